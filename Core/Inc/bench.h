@@ -0,0 +1,252 @@
+/**
+ * @file bench.h
+ * @brief Benchmark registry and common measurement driver.
+ *
+ * Each kernel is described by a bench_t entry in the registry: the driver
+ * generates a fresh input with the entry's generator at every iteration,
+ * from a seed derived from the iteration index (see bench_iteration_seed), and
+ * measures the kernel call with the DWT cycle counter, minus the overhead of
+ * the timed window measured at startup. The first iterations only warm up
+ * the kernel and are discarded (see bench_options_t). The samples are kept in
+ * RAM during the run and reported at its end (see bench_output.h), followed
+ * by a summary line with streaming statistics (see bench_stats.h), the
+ * peak stack use of the kernel (see bench_stack.h) and the checksum of the
+ * outputs of the measured iterations.
+ *
+ * The kernels take their dimensions and parameters at runtime, up to a
+ * compile-time maximum, so the registry lists every configuration of every
+ * kernel and a single image sweeps all of them.
+ */
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <stdint.h>
+#include "bench_stats.h"
+
+// Number of samples buffered in RAM before they are reported. Each one takes
+// 13 bytes of static RAM (cycles and profiling counters), which is left to
+// the stack of the kernels otherwise.
+#ifndef BENCH_MAX_SAMPLES
+#define BENCH_MAX_SAMPLES 500
+#endif
+
+// Number of runs of the empty kernel used to measure the timer overhead
+#ifndef BENCH_CALIBRATION_ITERS
+#define BENCH_CALIBRATION_ITERS 64
+#endif
+
+// Length of the timed window targeted when choosing the inner repeats
+#ifndef BENCH_TARGET_WINDOW
+#define BENCH_TARGET_WINDOW 100000
+#endif
+
+// bench_t.repeat value that lets the driver choose the inner repeats
+#define BENCH_REPEAT_AUTO 0
+
+// Default of bench_options.quiet
+#ifndef BENCH_QUIET
+#define BENCH_QUIET 0
+#endif
+
+// Longest timed window run in quiet mode, in cycles. The wraps of CYCCNT are
+// not tracked while the tick is suspended (see cycle_clock.h), so the
+// windows of a run whose pilot window is longer run with the tick instead.
+#ifndef BENCH_QUIET_MAX_WINDOW
+#define BENCH_QUIET_MAX_WINDOW 0x80000000u
+#endif
+
+// Default of bench_options.profile
+#ifndef BENCH_PROFILE
+#define BENCH_PROFILE 0
+#endif
+
+// Default of bench_options.warmup
+#ifndef BENCH_WARMUP
+#define BENCH_WARMUP 10
+#endif
+
+// Default of bench_options.steady
+#ifndef BENCH_STEADY
+#define BENCH_STEADY 0
+#endif
+
+// Coefficient of variation of the last BENCH_WINDOW_LEN warmup samples below
+// which the steady state is reached
+#ifndef BENCH_STEADY_CV
+#define BENCH_STEADY_CV 0.02
+#endif
+
+// Maximum number of warmup iterations in steady state mode
+#ifndef BENCH_STEADY_MAX_WARMUP
+#define BENCH_STEADY_MAX_WARMUP 500
+#endif
+
+// Default of bench_options.seed
+#ifndef BENCH_SEED
+#define BENCH_SEED 42
+#endif
+
+// When 1, main() replays iteration BENCH_REPLAY_INDEX of registry entry
+// BENCH_REPLAY_ENTRY instead of running the whole suite
+#ifndef BENCH_REPLAY
+#define BENCH_REPLAY 0
+#endif
+#ifndef BENCH_REPLAY_ENTRY
+#define BENCH_REPLAY_ENTRY 0
+#endif
+#ifndef BENCH_REPLAY_INDEX
+#define BENCH_REPLAY_INDEX 0
+#endif
+
+// When 1, the copies of the kernels placed in RAM are built as well, and
+// main() compares the two placements (see kernel_placement.h)
+#ifndef BENCH_RAM_KERNELS
+#define BENCH_RAM_KERNELS 0
+#endif
+
+// Checksum of a run without iterations; the checksum returned by the kernel
+// at each iteration is folded into it
+#define BENCH_CHECKSUM_INIT 2166136261u
+
+// Default of bench_options.raw
+#ifndef BENCH_RAW
+#define BENCH_RAW 1
+#endif
+
+/**
+ * @brief Element type of the input array of a kernel.
+ */
+typedef enum
+{
+  BENCH_INPUT_DOUBLE, // double[input_len]
+  BENCH_INPUT_UINT    // unsigned int[input_len]
+} bench_input_t;
+
+typedef struct bench bench_t;
+
+/**
+ * @brief Kernel entry point, selected by the input type. The kernel returns
+ *        a checksum of its output, which the driver stores in a volatile
+ *        sink so that the work cannot be optimized away.
+ */
+typedef union
+{
+  unsigned int (*f64)(double *input);
+  unsigned int (*u32)(unsigned int *input);
+} bench_kernel_t;
+
+/**
+ * @brief Benchmark descriptor.
+ */
+struct bench
+{
+  const char *name;         // Human readable name of the kernel
+  // Short name of the kernel, the prefix of its files in measurements/
+  // (<short_name>_<config>.csv)
+  const char *short_name;
+  uint32_t config;          // Configuration id of the kernel (Config 1/2/3)
+  bench_input_t input_type; // Element type of the input
+  uint32_t input_len;       // Number of elements of the input
+  // Fills the input array (input_len elements of type input_type)
+  void (*generate)(const bench_t *bench, void *input);
+  // Parameters of the generator
+  int32_t scale;
+  int32_t offset;
+  // Parameters of the kernel (dimensions, constants), passed to configure
+  const void *params;
+  // Applies params to the kernel before the run, outside of the timed
+  // windows; returns 0 on success. NULL for kernels without parameters.
+  int (*configure)(const bench_t *bench);
+  // Calls of the kernel on the same input in each timed window; the sample
+  // is their average. BENCH_REPEAT_AUTO targets BENCH_TARGET_WINDOW cycles.
+  // The kernel must reset its own state at every call.
+  uint32_t repeat;
+  // Kernel entry point, selected by input_type
+  bench_kernel_t run;
+  // Copy of the kernel placed in RAM and its configure hook, with
+  // BENCH_RAM_KERNELS; NULL otherwise
+  bench_kernel_t run_ram;
+  int (*configure_ram)(const bench_t *bench);
+};
+
+/**
+ * @brief Runtime options of the driver.
+ */
+typedef struct
+{
+  // Suspend the HAL tick and mask the interrupts during the timed windows.
+  // The interrupts held back and the windows in which an exception was
+  // taken anyway (DWT EXCCNT != 0) are reported at the end of the run.
+  uint8_t quiet;
+  // Record the DWT profiling counters of every iteration (see bench_profile_t)
+  uint8_t profile;
+  // Report every sample; when 0 only the summary line of each run is sent
+  uint8_t raw;
+  // Format of the samples, BENCH_OUTPUT_TEXT or BENCH_OUTPUT_BINARY (see
+  // bench_output.h)
+  uint8_t output;
+  // Keep warming up after the warmup iterations, until the coefficient of
+  // variation of the last samples drops below BENCH_STEADY_CV or
+  // BENCH_STEADY_MAX_WARMUP iterations are run. Since every iteration has a
+  // different input, kernels whose time depends on the input may not reach
+  // the threshold.
+  uint8_t steady;
+  // Iterations run before the measured ones, excluded from the samples and
+  // the statistics (cold flash prefetch and caches, first-touch effects)
+  uint32_t warmup;
+  // Base seed of the inputs: iteration i of every run is generated from
+  // bench_iteration_seed(seed, i), so it can be replayed on its own
+  uint32_t seed;
+} bench_options_t;
+
+/**
+ * @brief DWT profiling counters of a timed window. The counters are 8 bits
+ *        wide and wrap silently, so the values are modulo 256: they are exact
+ *        only for windows with fewer than 256 events of each kind. The number
+ *        of executed instructions is
+ *          cycles - cpi - exc - sleep - lsu + fold  (mod 256)
+ */
+typedef struct
+{
+  uint8_t cpi;   // Extra cycles of multi-cycle instructions (incl. flash wait states)
+  uint8_t exc;   // Cycles spent in exception entry and exit
+  uint8_t sleep; // Cycles spent sleeping
+  uint8_t lsu;   // Extra cycles of load/store instructions
+  uint8_t fold;  // Folded (zero cycle) instructions
+} bench_profile_t;
+
+extern bench_options_t bench_options;
+
+extern const bench_t bench_registry[];
+extern const uint32_t bench_registry_len;
+
+// Statically placed, 8-byte aligned buffer of the inputs, sized for the
+// largest input allowed by the kernels of the registry (section .bench_arena,
+// between the heap and the stack reserve). A kernel that needs more stack
+// than the reserve may grow into the part of the arena that its input leaves
+// free; the run fails if the stack reaches the input.
+extern uint64_t bench_arena[];
+extern const uint32_t bench_arena_size;
+
+void bench_init(void);
+int bench_run(const bench_t *bench, uint32_t iter, bench_stats_t *result);
+void bench_run_all(uint32_t iter);
+int bench_replay(const bench_t *bench, uint32_t index, uint32_t times);
+
+/**
+ * @brief Adds the checksum returned by the kernel at an iteration to the
+ *        checksum of a run (FNV-1a over 32-bit words), which starts at
+ *        BENCH_CHECKSUM_INIT.
+ */
+static inline uint32_t bench_fold_checksum(uint32_t checksum, unsigned int value)
+{
+  return (checksum ^ value) * 16777619u;
+}
+
+// Inputs: seeds and generators (see bench_registry.c)
+uint32_t bench_iteration_seed(uint32_t seed, uint32_t index);
+void bench_gen_double(const bench_t *bench, void *input);
+void bench_gen_uint(const bench_t *bench, void *input);
+void bench_gen_pathfind(const bench_t *bench, void *input);
+
+#endif
@@ -0,0 +1,41 @@
+/**
+ * @file bench_clock.h
+ * @brief System clock sweep: the suite is run again under each entry of a
+ * table of clock configurations, with the flash latency and the regulator
+ * voltage range each of them requires.
+ *
+ * Every configuration is applied from HSI at voltage range 1, which can
+ * reach all of them, so that the order of the table does not matter. The
+ * UART is initialized again at every change, to keep its baud rate.
+ */
+#ifndef BENCH_CLOCK_H
+#define BENCH_CLOCK_H
+
+#include <stdint.h>
+
+// When 1, main() runs the suite under every entry of bench_clocks
+#ifndef BENCH_CLOCK_SWEEP
+#define BENCH_CLOCK_SWEEP 0
+#endif
+
+/**
+ * @brief System clock configuration.
+ */
+typedef struct
+{
+  const char *name;
+  uint32_t sysclk_source; // RCC_SYSCLKSOURCE_MSI, _HSI or _PLLCLK
+  uint32_t msi_range;     // RCC_MSIRANGE_x, for the MSI
+  uint32_t pll_mul;       // RCC_PLL_MULx, for the PLL (fed by the HSI)
+  uint32_t pll_div;       // RCC_PLL_DIVx, for the PLL
+  uint32_t voltage_scale; // PWR_REGULATOR_VOLTAGE_SCALEx
+  uint32_t flash_latency; // FLASH_LATENCY_x
+} bench_clock_t;
+
+extern const bench_clock_t bench_clocks[];
+extern const uint32_t bench_clocks_len;
+
+int bench_clock_set(const bench_clock_t *clock);
+void bench_clock_sweep(uint32_t iter);
+
+#endif
@@ -0,0 +1,44 @@
+/**
+ * @file bench_flash.h
+ * @brief Flash accelerator sweep: every benchmark is run under each setting
+ * of the FLASH_ACR bits (prefetch, 64-bit access, latency) that the system
+ * clock allows, and the mean cycles are compared with the first setting.
+ *
+ * On the STM32L1 one wait state and the prefetch both require the 64-bit
+ * access, so the valid settings are 32-bit/0 WS and 64-bit with prefetch
+ * on or off and 0 or 1 WS. 0 WS is allowed up to 16, 8 and 2.1 MHz in the
+ * voltage ranges 1, 2 and 3.
+ */
+#ifndef BENCH_FLASH_H
+#define BENCH_FLASH_H
+
+#include <stdint.h>
+
+// When 1, main() runs the flash accelerator sweep
+#ifndef BENCH_FLASH_SWEEP
+#define BENCH_FLASH_SWEEP 0
+#endif
+
+// Entry of bench_clocks the sweep runs at: the default (HSI 16 MHz) allows
+// both latencies
+#ifndef BENCH_FLASH_SWEEP_CLOCK
+#define BENCH_FLASH_SWEEP_CLOCK 2
+#endif
+
+/**
+ * @brief Setting of the flash accelerator.
+ */
+typedef struct
+{
+  uint8_t prefetch; // Prefetch buffer enabled
+  uint8_t acc64;    // 64-bit access
+  uint8_t latency;  // Wait states
+} bench_flash_t;
+
+extern const bench_flash_t bench_flash_settings[];
+extern const uint32_t bench_flash_settings_len;
+
+int bench_flash_set(const bench_flash_t *flash);
+void bench_flash_sweep(uint32_t iter);
+
+#endif
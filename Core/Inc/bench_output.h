@@ -0,0 +1,60 @@
+/**
+ * @file bench_output.h
+ * @brief Reporting of the samples collected by the benchmark driver.
+ *
+ * Samples can be sent either as text (one value per line, the layout of the
+ * files in measurements/) or as binary frames. A frame is laid out as follows
+ * (multi-byte fields are little-endian):
+ *
+ *   offset  size  field
+ *   0       2     magic (BENCH_FRAME_MAGIC_0, BENCH_FRAME_MAGIC_1)
+ *   2       2     length of the frame body, from 'type' to the last sample
+ *   4       1     frame type (BENCH_FRAME_SAMPLES_U32/U64/PROFILE)
+ *   5       1     benchmark config id
+ *   6       1     length N of the benchmark name
+ *   7       N     benchmark name (not NUL terminated)
+ *   7+N     4     index of the first sample of the frame in the run
+ *   11+N    2     number of samples M
+ *   13+N    S*M   samples, S = 4 (U32), 8 (U64) or 5 (PROFILE) bytes each
+ *   13+N+SM 4     CRC-32 (IEEE 802.3) of the frame body
+ *
+ * Frames whose samples all fit in 32 bits use the U32 type. In profiling mode
+ * each frame of cycle counts is followed by a PROFILE frame with the same
+ * first index, whose samples are the cpi, exc, sleep, lsu and fold counters.
+ * In text mode the counters follow the cycle count on the same line,
+ * separated by commas.
+ */
+#ifndef BENCH_OUTPUT_H
+#define BENCH_OUTPUT_H
+
+#include <stdint.h>
+#include "bench.h"
+
+#define BENCH_OUTPUT_TEXT 0
+#define BENCH_OUTPUT_BINARY 1
+
+// Default of bench_options.output
+#ifndef BENCH_OUTPUT
+#define BENCH_OUTPUT BENCH_OUTPUT_BINARY
+#endif
+
+#define BENCH_FRAME_MAGIC_0 0xB5
+#define BENCH_FRAME_MAGIC_1 0x62
+// Maximum number of samples carried by a single frame
+#define BENCH_FRAME_MAX_SAMPLES 64
+
+// Frame types
+#define BENCH_FRAME_SAMPLES_U32 0x01
+#define BENCH_FRAME_SAMPLES_U64 0x02
+#define BENCH_FRAME_PROFILE 0x03
+
+// Size of the buffer for bench_u64_str()
+#define BENCH_U64_STR_LEN 21
+
+void bench_output_samples(const bench_t *bench, uint32_t first,
+                          const uint64_t *samples,
+                          const bench_profile_t *profiles, uint32_t count);
+char *bench_u64_str(uint64_t value, char buf[BENCH_U64_STR_LEN]);
+uint32_t bench_crc32(uint32_t crc, const uint8_t *data, uint32_t len);
+
+#endif
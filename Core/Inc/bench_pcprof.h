@@ -0,0 +1,53 @@
+/**
+ * @file bench_pcprof.h
+ * @brief Statistical profiler: TIM6 interrupts the kernel at a fixed period
+ * and records the interrupted PC, read from the exception stack frame, in a
+ * table of exact PCs with their sample counts.
+ *
+ * The table is reset before the measured iterations of a run, sampled only
+ * inside the timed windows, and reported after the summary line as text:
+ *
+ *   PC profile <name> config <id>: <n> samples, <d> dropped, period <p> cycles
+ *   PC 0x<address> <count>
+ *   ...
+ *   PC profile end
+ *
+ * Samples whose PC does not fit the full table are counted as dropped.
+ * Tools/pc_profile.py symbolizes the table against the ELF. The interrupts
+ * lengthen the timed windows, so the cycle counts of a profiled run are not
+ * comparable with the others; in quiet mode the interrupts are masked and no
+ * sample is taken. The table is ordinary .bss, 6 bytes per slot (3 KB at the
+ * default 512 slots), so it comes out of the stack headroom between .bss and
+ * the stack reserve. If the link fails the stack reserve check or the largest
+ * configurations run short of stack, lower BENCH_PC_PROFILE_SLOTS; the reserve
+ * itself is _Min_Stack_Size in the linker script.
+ */
+#ifndef BENCH_PCPROF_H
+#define BENCH_PCPROF_H
+
+#include <stdint.h>
+#include "bench.h"
+
+// When 1, every run is profiled
+#ifndef BENCH_PC_PROFILE
+#define BENCH_PC_PROFILE 0
+#endif
+
+// Sampling period in timer cycles (the system clock, with the APB1 prescaler
+// at 1), at most 65536. A prime keeps the samples from locking onto a loop.
+#ifndef BENCH_PC_PROFILE_PERIOD
+#define BENCH_PC_PROFILE_PERIOD 997
+#endif
+
+// Number of distinct PCs the table can hold, a power of 2
+#ifndef BENCH_PC_PROFILE_SLOTS
+#define BENCH_PC_PROFILE_SLOTS 512
+#endif
+
+void bench_pcprof_init(void);
+void bench_pcprof_reset(void);
+void bench_pcprof_resume(void);
+void bench_pcprof_pause(void);
+void bench_pcprof_report(const bench_t *bench);
+
+#endif
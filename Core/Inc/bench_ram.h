@@ -0,0 +1,13 @@
+/**
+ * @file bench_ram.h
+ * @brief Comparison of the kernels run from flash and from RAM, built with
+ * BENCH_RAM_KERNELS (see kernel_placement.h).
+ */
+#ifndef BENCH_RAM_H
+#define BENCH_RAM_H
+
+#include <stdint.h>
+
+void bench_ram_compare(uint32_t iter);
+
+#endif
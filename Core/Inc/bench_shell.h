@@ -0,0 +1,43 @@
+/**
+ * @file bench_shell.h
+ * @brief Command interpreter on the UART, to select and run the benchmarks
+ * at runtime instead of the fixed sequence of main().
+ *
+ * Commands are lines of words separated by spaces, terminated by CR or LF:
+ *
+ *   help                 list the commands
+ *   list                 list the registry entries: index, name, config, input length
+ *   select <index>       select a registry entry
+ *   config <id>          select another config of the selected kernel
+ *   iters <n>            measured iterations of each run
+ *   seed <n>             base seed of the inputs (bench_options.seed)
+ *   warmup <n>           warmup iterations (bench_options.warmup)
+ *   output text|binary   format of the samples (bench_options.output)
+ *   show                 print the selection and the options
+ *   run                  run the selected benchmark
+ *   all                  run every benchmark of the registry
+ *
+ * The output of each command ends with a line "OK" or "ERR <reason>", so that
+ * a host script can wait for it before sending the next command. The input is
+ * not echoed. Bytes received during a run are kept for the next command, but
+ * their interrupts disturb the measurements unless bench_options.quiet is set.
+ */
+#ifndef BENCH_SHELL_H
+#define BENCH_SHELL_H
+
+#include <stdint.h>
+
+// When 1, main() starts the shell instead of running the suite
+#ifndef BENCH_SHELL
+#define BENCH_SHELL 0
+#endif
+
+// Longest command line, terminator excluded
+#ifndef BENCH_SHELL_LINE_LEN
+#define BENCH_SHELL_LINE_LEN 63
+#endif
+
+void bench_shell_init(uint32_t iter);
+void bench_shell_poll(void);
+
+#endif
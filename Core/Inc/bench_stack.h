@@ -0,0 +1,24 @@
+/**
+ * @file bench_stack.h
+ * @brief Stack high-water mark measurement by stack painting.
+ *
+ * bench_stack_paint() fills the free stack, between the end of the input in
+ * the arena and the current stack pointer, with a known pattern;
+ * bench_stack_used() finds the lowest word that no longer holds the pattern,
+ * and bench_stack_overrun() tells whether the stack reached the input.
+ * Interrupts taken in the meantime push their frames on the same stack, and
+ * are counted as well.
+ */
+#ifndef BENCH_STACK_H
+#define BENCH_STACK_H
+
+#include <stdint.h>
+
+// Pattern of the painted words
+#define BENCH_STACK_PATTERN 0xA5A5A5A5
+
+void bench_stack_paint(const void *bottom);
+uint32_t bench_stack_used(void);
+int bench_stack_overrun(void);
+
+#endif
@@ -0,0 +1,70 @@
+/**
+ * @file bench_stats.h
+ * @brief Streaming statistics of the samples of a benchmark run.
+ *
+ * Mean and variance are updated with Welford's algorithm; the quantiles are
+ * estimated with the P^2 algorithm (Jain & Chlamtac, 1985), which keeps five
+ * markers per quantile instead of the samples. A sliding window over the
+ * last samples gives the coefficient of variation used to detect the steady
+ * state during the warmup.
+ */
+#ifndef BENCH_STATS_H
+#define BENCH_STATS_H
+
+#include <stdint.h>
+
+// Number of samples of the sliding window
+#ifndef BENCH_WINDOW_LEN
+#define BENCH_WINDOW_LEN 16
+#endif
+
+/**
+ * @brief P^2 estimator of a single quantile.
+ */
+typedef struct
+{
+  double p;       // The quantile, in (0, 1)
+  uint32_t count; // Observations so far
+  double q[5];    // Marker heights
+  double n[5];    // Marker positions
+  double np[5];   // Desired marker positions
+  double dn[5];   // Increments of the desired positions
+} bench_p2_t;
+
+/**
+ * @brief Statistics of a run.
+ */
+typedef struct
+{
+  uint32_t count;
+  uint64_t min;
+  uint64_t max;
+  double mean;
+  double m2; // Sum of the squared differences from the mean
+  bench_p2_t p50;
+  bench_p2_t p90;
+  bench_p2_t p99;
+} bench_stats_t;
+
+/**
+ * @brief Sliding window over the last BENCH_WINDOW_LEN samples.
+ */
+typedef struct
+{
+  uint64_t samples[BENCH_WINDOW_LEN];
+  uint32_t count; // Samples added so far
+} bench_window_t;
+
+void bench_stats_init(bench_stats_t *stats);
+void bench_stats_add(bench_stats_t *stats, uint64_t sample);
+double bench_stats_stddev(const bench_stats_t *stats);
+
+void bench_window_init(bench_window_t *window);
+void bench_window_add(bench_window_t *window, uint64_t sample);
+double bench_window_cv(const bench_window_t *window);
+
+void bench_p2_init(bench_p2_t *p2, double p);
+void bench_p2_add(bench_p2_t *p2, double x);
+double bench_p2_get(const bench_p2_t *p2);
+
+#endif
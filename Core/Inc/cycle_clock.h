@@ -0,0 +1,23 @@
+/**
+ * @file cycle_clock.h
+ * @brief 64-bit cycle clock built on top of the 32-bit DWT CYCCNT.
+ *
+ * CYCCNT wraps every 2^32 cycles (about 134 s at 32 MHz). The clock counts
+ * the wraps it observes, so it must be read at least once per CYCCNT period,
+ * also in the middle of a long timed window: SysTick_Handler() calls
+ * cycle_clock_update(), which reads it every CYCLE_CLOCK_UPDATE_TICKS ticks,
+ * so that the windows see a short masked section once per second rather
+ * than at every tick. With the tick suspended (quiet mode) nothing reads it,
+ * so the driver keeps quiet mode to the windows well below a period (see
+ * BENCH_QUIET_MAX_WINDOW in bench.h).
+ */
+#ifndef CYCLE_CLOCK_H
+#define CYCLE_CLOCK_H
+
+#include <stdint.h>
+
+void cycle_clock_init(void);
+uint64_t cycle_clock_now(void);
+void cycle_clock_update(void);
+
+#endif
@@ -1,13 +1,26 @@
 #ifndef HUFFMAN_H
 #define HUFFMAN_H
 
-// Config 1
-#define HUFFMAN_INPUT_SIZE 100
-// Config 2
-//#define HUFFMAN_INPUT_SIZE 1000
-// Config 3
-//#define HUFFMAN_INPUT_SIZE 10000
-
-void huffman_compression(unsigned int input[HUFFMAN_INPUT_SIZE]);
+// Maximum length of the input
+#define HUFFMAN_MAX_INPUT_SIZE 10000
+
+typedef struct {
+    unsigned int input_size; // Number of characters to compress
+} huffman_config_t;
+
+// Receives the code of each call, code_len bits stored from the most
+// significant bit of code[0], and the decoded string. The hook is only built
+// with KERNEL_OUTPUT_HOOKS (see kernel_placement.h), for the host tests.
+typedef void (*huffman_output_t)(const unsigned int code[], unsigned int code_len,
+                                 const char decoded[]);
+
+int huffman_configure(const huffman_config_t *config);
+void huffman_set_output(huffman_output_t output);
+// Returns a checksum of the decoded string
+unsigned int huffman_compression(unsigned int input[]);
+// Copy placed in RAM, built with BENCH_RAM_KERNELS (see kernel_placement.h)
+int huffman_configure_ram(const huffman_config_t *config);
+void huffman_set_output_ram(huffman_output_t output);
+unsigned int huffman_compression_ram(unsigned int input[]);
 
 #endif
@@ -0,0 +1,29 @@
+/**
+ * @file kernel_placement.h
+ * @brief Placement of the hot functions of the kernels.
+ *
+ * The kernel functions are marked with KERNEL_RAMFUNC, following the
+ * __RAM_FUNC pattern of stm32l1xx_hal_flash_ramfunc.c. In the kernel
+ * sources the mark is empty and the functions stay in flash. With
+ * BENCH_RAM_KERNELS, the *_ram.c files include the sources again with
+ * KERNEL_RAMFUNC_SECTION set to a .RamFunc.<kernel> section. The linker
+ * places it with .data, and the startup code copies it to RAM. Calls to
+ * the C library and to the soft-float routines stay in flash.
+ */
+#ifndef KERNEL_PLACEMENT_H
+#define KERNEL_PLACEMENT_H
+
+#ifdef KERNEL_RAMFUNC_SECTION
+#define KERNEL_RAMFUNC __attribute__((section(KERNEL_RAMFUNC_SECTION)))
+#else
+#define KERNEL_RAMFUNC
+#endif
+
+// When 1, the kernels pass their results to the receiver set with
+// <kernel>_set_output. The host tests build with it; the firmware and the
+// host harness do not, so the timed kernels carry no hook.
+#ifndef KERNEL_OUTPUT_HOOKS
+#define KERNEL_OUTPUT_HOOKS 0
+#endif
+
+#endif
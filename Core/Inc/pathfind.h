@@ -1,21 +1,37 @@
 #ifndef PATHFIND_H
 #define PATHFIND_H
 
-// config 1
-#define PATHFIND_INPUT_SIZE 29
-#define PATHFIND_HEIGHT 5
-#define PATHFIND_WIDTH 5
+// Maximum dimensions of the map
+#define PATHFIND_MAX_HEIGHT 20
+#define PATHFIND_MAX_WIDTH 20
 
-// config 2
-//#define PATHFIND_INPUT_SIZE 104
-//#define PATHFIND_HEIGHT 10
-//#define PATHFIND_WIDTH 10
+// Length of the input: start and goal coordinates, followed by the map
+#define PATHFIND_INPUT_SIZE(height, width) (4 + (height) * (width))
+#define PATHFIND_MAX_INPUT_SIZE PATHFIND_INPUT_SIZE(PATHFIND_MAX_HEIGHT, PATHFIND_MAX_WIDTH)
 
-// config 3
-//#define PATHFIND_INPUT_SIZE 404
-//#define PATHFIND_HEIGHT 20
-//#define PATHFIND_WIDTH 20
+typedef struct
+{
+    int height;
+    int width;
+} pathfind_config_t;
 
-void pathfind(unsigned int input[PATHFIND_INPUT_SIZE]);
+typedef struct
+{
+    int x, y;
+} pathfind_point_t;
+
+// Receives the path found by each call with valid, distinct start and goal,
+// from the goal back to the start (length 0 if there is none). The hook is only
+// built with KERNEL_OUTPUT_HOOKS (see kernel_placement.h), for the host tests.
+typedef void (*pathfind_output_t)(const pathfind_point_t path[], int length);
+
+int pathfind_configure(const pathfind_config_t *config);
+void pathfind_set_output(pathfind_output_t output);
+// Returns a checksum of the path found
+unsigned int pathfind(unsigned int input[]);
+// Copy placed in RAM, built with BENCH_RAM_KERNELS (see kernel_placement.h)
+int pathfind_configure_ram(const pathfind_config_t *config);
+void pathfind_set_output_ram(pathfind_output_t output);
+unsigned int pathfind_ram(unsigned int input[]);
 
 #endif
@@ -2,33 +2,16 @@
 #define PWM_H
 
 
+// Maximum length of the input
+#define PWM_MAX_INPUT_SIZE 300
 
-// Config 1
-#define PWM_INPUT_SIZE 100
-#define PWM_INPUT_SCALE 5
-// Fan parameters
-#define PWM_TEMP_TH 50    // [°C]
-#define PWM_AIRFLOW 0.07  // [m^3/s]
-// Fan constants
-#define FAN_AREA 0.0113   // [m^2] circular area of a 12x12cm fan
-#define FAN_DISTANCE 0.1  // [m] distance of the fan from the surface
-
-// Config 2
-//#define PWM_INPUT_SIZE 200
-//#define PWM_INPUT_SCALE 5
-//#define PWM_TEMP_TH 30    // [°C]
-//#define PWM_AIRFLOW 0.1   // [m^3/s]
-//#define FAN_AREA 0.0113   // [m^2] circular area of a 12x12cm fan
-//#define FAN_DISTANCE 0.07 // [m] distance of the fan from the surface
-
-// Config 3
-//#define PWM_INPUT_SIZE 300
-//#define PWM_INPUT_SCALE 5
-//#define PWM_TEMP_TH 25      // [°C]
-//#define PWM_AIRFLOW 0.15    // [m^3/s]
-//#define FAN_AREA 0.0113     // [m^2] circular area of a 12x12cm fan
-//#define FAN_DISTANCE 0.05   // [m] distance of the fan from the surface
-
+typedef struct {
+    int input_size;      // Length of the heat time series
+    double temp_th;      // [°C] threshold temperature
+    double airflow;      // [m^3/s] airflow of the fan
+    double fan_area;     // [m^2] circular area of the fan
+    double fan_distance; // [m] distance of the fan from the surface
+} pwm_config_t;
 
 // PID controller values
 #define PWM_Kp 1
@@ -40,6 +23,19 @@
 #define CHARACT_LEN 0.1    // [m] (length of the surface)
 #define ALUMINIUM_CP 0.897 // [J/(Kg*K)]
 
-void pwm_fan_speed(double input[PWM_INPUT_SIZE]);
+// Receives the state after each step of a simulation: the temperatures of the
+// naturally cooled and of the fan cooled system [°C], and the duty cycle of the
+// fan. The hook is only built with KERNEL_OUTPUT_HOOKS (see
+// kernel_placement.h), for the host tests.
+typedef void (*pwm_output_t)(double current_temp, double expected_temp, double dc);
+
+int pwm_configure(const pwm_config_t *config);
+void pwm_set_output(pwm_output_t output);
+// Returns a checksum of the final temperatures and duty cycle
+unsigned int pwm_fan_speed(double input[]);
+// Copy placed in RAM, built with BENCH_RAM_KERNELS (see kernel_placement.h)
+int pwm_configure_ram(const pwm_config_t *config);
+void pwm_set_output_ram(pwm_output_t output);
+unsigned int pwm_fan_speed_ram(double input[]);
 
 #endif
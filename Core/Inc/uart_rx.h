@@ -0,0 +1,23 @@
+/**
+ * @file uart_rx.h
+ * @brief Interrupt driven reception on USART2.
+ *
+ * Once started, every byte received is stored by the USART2 interrupt in a
+ * ring buffer, from which uart_rx_getchar() takes it. Bytes received while
+ * the buffer is full are dropped. The reception must be started again after
+ * the UART is initialized again (e.g. by bench_clock_set()).
+ */
+#ifndef UART_RX_H
+#define UART_RX_H
+
+#include <stdint.h>
+
+// Size of the reception ring buffer
+#ifndef UART_RX_BUFFER_SIZE
+#define UART_RX_BUFFER_SIZE 128
+#endif
+
+void uart_rx_start(void);
+int uart_rx_getchar(void);
+
+#endif
@@ -0,0 +1,23 @@
+/**
+ * @file uart_tx.h
+ * @brief Non-blocking transmission on USART2.
+ *
+ * Bytes are queued in a ring buffer and sent by DMA1 channel 7: the writer
+ * only waits when the buffer is full. uart_tx_flush() waits until everything
+ * queued has left the UART, and must be called with interrupts enabled.
+ */
+#ifndef UART_TX_H
+#define UART_TX_H
+
+#include <stdint.h>
+
+// Size of the transmission ring buffer
+#ifndef UART_TX_BUFFER_SIZE
+#define UART_TX_BUFFER_SIZE 1024
+#endif
+
+void uart_tx_putchar(uint8_t ch);
+void uart_tx_write(const uint8_t *data, uint32_t len);
+void uart_tx_flush(void);
+
+#endif
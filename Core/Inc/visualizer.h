@@ -1,22 +1,31 @@
 #ifndef VISUALIZER_H
 #define VISUALIZER_H
 
-// Config 1
-#define VIS_WIDTH 300
-#define VIS_HEIGHT 200
-#define VIS_INPUT_SIZE 100
-#define VIS_INPUT_SCALE 100
-// Config 2
-//#define VIS_WIDTH 500
-//#define VIS_HEIGHT 100
-//#define VIS_INPUT_SIZE 300
-//#define VIS_INPUT_SCALE 100
-// Config 3
-//#define VIS_WIDTH 300
-//#define VIS_HEIGHT 197
-//#define VIS_INPUT_SIZE 1000
-//#define VIS_INPUT_SCALE 100
+// Maximum dimensions of the image and length of the input. The image is
+// allocated on the stack, so the area is bounded as well.
+#define VIS_MAX_WIDTH 500
+#define VIS_MAX_HEIGHT 200
+#define VIS_MAX_AREA 60000
+#define VIS_MAX_INPUT_SIZE 1000
 
-void visualizer(double input[VIS_INPUT_SIZE]);
+typedef struct {
+    int width;      // Width of the image
+    int height;     // Height of the image
+    int input_size; // Length of the time series
+} vis_config_t;
+
+// Receives the image drawn by each call, height rows of width '0'/'1'
+// characters. The hook is only built with KERNEL_OUTPUT_HOOKS (see
+// kernel_placement.h), for the host tests.
+typedef void (*vis_output_t)(int height, int width, const char *image);
+
+int visualizer_configure(const vis_config_t *config);
+void visualizer_set_output(vis_output_t output);
+// Returns a checksum of the lines drawn (the positions of their last pixels)
+unsigned int visualizer(double input[]);
+// Copy placed in RAM, built with BENCH_RAM_KERNELS (see kernel_placement.h)
+int visualizer_configure_ram(const vis_config_t *config);
+void visualizer_set_output_ram(vis_output_t output);
+unsigned int visualizer_ram(double input[]);
 
 #endif
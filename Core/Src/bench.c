@@ -0,0 +1,632 @@
+/**
+ * @file bench.c
+ * @brief Common measurement driver for the benchmarks in the registry.
+ */
+
+#include <stdio.h>
+#include <math.h>
+#include "main.h"
+#include "bench.h"
+#include "bench_output.h"
+#include "uart_tx.h"
+#include "cycle_clock.h"
+#include "bench_stats.h"
+#include "bench_stack.h"
+#include "bench_pcprof.h"
+#include "simple_random.h"
+#include "visualizer.h"
+#include "pwm-fan-speed.h"
+#include "huffman-compression.h"
+#include "pathfind.h"
+
+#define MAX(a, b) ((a) > (b) ? (a) : (b))
+
+// Largest input allowed by the kernels, in bytes
+#define ARENA_SIZE                                                                          \
+  MAX(MAX(VIS_MAX_INPUT_SIZE * sizeof(double), PWM_MAX_INPUT_SIZE * sizeof(double)),       \
+      MAX(HUFFMAN_MAX_INPUT_SIZE * sizeof(unsigned int), PATHFIND_MAX_INPUT_SIZE * sizeof(unsigned int)))
+
+// Inputs of the benchmarks, in their own section so that the arena shows in
+// the link map and stays at the same address in every run
+__attribute__((section(".bench_arena"), aligned(8))) uint64_t bench_arena[(ARENA_SIZE + 7) / 8];
+const uint32_t bench_arena_size = sizeof(bench_arena);
+
+// Cycle counts of the iterations, reported when the buffer is full or the
+// run is over, so that no I/O happens between two measurements
+static uint64_t samples[BENCH_MAX_SAMPLES];
+// DWT profiling counters of the iterations, filled in profiling mode
+static bench_profile_t profiles[BENCH_MAX_SAMPLES];
+
+bench_options_t bench_options = {
+  .quiet = BENCH_QUIET,
+  .profile = BENCH_PROFILE,
+  .raw = BENCH_RAW,
+  .output = BENCH_OUTPUT,
+  .steady = BENCH_STEADY,
+  .warmup = BENCH_WARMUP,
+  .seed = BENCH_SEED,
+};
+
+// Quiet mode bookkeeping
+static uint8_t quiet_active;       // Quiet mode applies to the timed windows
+static uint32_t quiet_primask;
+static uint64_t quiet_tick_cycles; // Cycles elapsed since the last HAL tick
+static uint32_t quiet_suppressed;  // Interrupts held back in the timed windows
+static uint32_t quiet_leaked;      // Timed windows in which an exception was taken
+
+// Cycles spent by an empty kernel in the timed window, for each input type
+static uint64_t overhead[2];
+// Cycles added by each further inner repeat of an empty kernel
+static uint64_t repeat_overhead[2];
+// Stack used by the driver frames down to an empty kernel
+static uint32_t stack_overhead;
+// Checksum returned by the last kernel call. Being volatile, the store in the
+// timed window keeps the result, and so the work of the kernel, alive.
+static volatile unsigned int sink;
+
+static uint64_t measure(const bench_t *bench, void *input, uint32_t repeat,
+                        bench_profile_t *profile);
+static void bench_calibrate(void);
+
+/**
+ * @brief Enables the DWT counters used by the driver, measures the overhead
+ *        of the timed window and reports the size of the input arena.
+ */
+void bench_init(void)
+{
+  cycle_clock_init();
+  DWT->CTRL |= DWT_CTRL_EXCEVTENA_Msk | DWT_CTRL_CPIEVTENA_Msk | DWT_CTRL_SLEEPEVTENA_Msk |
+               DWT_CTRL_LSUEVTENA_Msk | DWT_CTRL_FOLDEVTENA_Msk;
+#if BENCH_PC_PROFILE
+  bench_pcprof_init();
+#endif
+  bench_calibrate();
+  printf("Input arena: %lu bytes\r\n", (long unsigned int)bench_arena_size);
+}
+
+/**
+ * @brief Waits until all the pending output has left the UART, so that no
+ *        DMA transfer or interrupt overlaps the next measurement.
+ */
+static void drain_output(void)
+{
+  fflush(stdout);
+  uart_tx_flush();
+}
+
+/**
+ * @brief Counts the enabled interrupts that are pending in the NVIC.
+ */
+static uint32_t pending_interrupts(void)
+{
+  uint32_t count = 0;
+  for (uint32_t i = 0; i < sizeof(NVIC->ISPR) / sizeof(NVIC->ISPR[0]); ++i)
+  {
+    count += __builtin_popcount(NVIC->ISPR[i] & NVIC->ISER[i]);
+  }
+  return count;
+}
+
+/**
+ * @brief Suspends the HAL tick and masks all the maskable interrupts.
+ */
+static void quiet_enter(void)
+{
+  HAL_SuspendTick();
+  quiet_primask = __get_PRIMASK();
+  __disable_irq();
+}
+
+/**
+ * @brief Accounts the interrupts held back during the timed window, then
+ *        unmasks the interrupts and restores the HAL tick, adding the ticks
+ *        that elapsed while it was suspended.
+ *
+ * @param cycles: the length of the timed window
+ */
+static void quiet_exit(uint64_t cycles)
+{
+  if (DWT->EXCCNT != 0)
+  {
+    ++quiet_leaked;
+  }
+  uint32_t tick_period = SystemCoreClock / (1000U / uwTickFreq);
+  quiet_tick_cycles += cycles;
+  while (quiet_tick_cycles >= tick_period)
+  {
+    quiet_tick_cycles -= tick_period;
+    HAL_IncTick();
+    ++quiet_suppressed;
+  }
+  quiet_suppressed += pending_interrupts();
+  __set_PRIMASK(quiet_primask);
+  HAL_ResumeTick();
+}
+
+/**
+ * @brief Measures back-to-back calls of the kernel on the same input.
+ *
+ * @param bench: the descriptor of the benchmark
+ * @param input: the input of the kernel
+ * @param repeat: the number of calls in the timed window
+ * @param profile: where to store the DWT profiling counters, or NULL
+ * @return uint64_t: the number of elapsed cycles
+ */
+static uint64_t measure(const bench_t *bench, void *input, uint32_t repeat,
+                        bench_profile_t *profile)
+{
+  uint64_t start, cycles;
+  if (quiet_active)
+  {
+    quiet_enter();
+  }
+  DWT->EXCCNT = 0;
+  if (profile != NULL)
+  {
+    DWT->CPICNT = 0;
+    DWT->SLEEPCNT = 0;
+    DWT->LSUCNT = 0;
+    DWT->FOLDCNT = 0;
+  }
+#if BENCH_PC_PROFILE
+  bench_pcprof_resume();
+#endif
+  start = cycle_clock_now();
+  // Run the bench
+  if (bench->input_type == BENCH_INPUT_DOUBLE)
+  {
+    for (uint32_t r = 0; r < repeat; ++r)
+    {
+      sink = bench->run.f64((double *)input);
+    }
+  }
+  else
+  {
+    for (uint32_t r = 0; r < repeat; ++r)
+    {
+      sink = bench->run.u32((unsigned int *)input);
+    }
+  }
+  cycles = cycle_clock_now() - start;
+#if BENCH_PC_PROFILE
+  bench_pcprof_pause();
+#endif
+  if (profile != NULL)
+  {
+    profile->cpi = DWT->CPICNT;
+    profile->exc = DWT->EXCCNT;
+    profile->sleep = DWT->SLEEPCNT;
+    profile->lsu = DWT->LSUCNT;
+    profile->fold = DWT->FOLDCNT;
+  }
+  if (quiet_active)
+  {
+    quiet_exit(cycles);
+  }
+  return cycles;
+}
+
+// Empty kernels, used to measure the overhead of the timed window
+__attribute__((noinline)) static unsigned int empty_f64(double *input)
+{
+  __asm volatile("" : : "r"(input) : "memory");
+  return 0;
+}
+
+__attribute__((noinline)) static unsigned int empty_u32(unsigned int *input)
+{
+  __asm volatile("" : : "r"(input) : "memory");
+  return 0;
+}
+
+/**
+ * @brief Minimum of BENCH_CALIBRATION_ITERS measurements of an empty kernel.
+ */
+static uint64_t measure_empty(const bench_t *empty, uint32_t repeat)
+{
+  uint64_t input = 0;
+  uint64_t min = UINT64_MAX;
+  for (uint32_t i = 0; i < BENCH_CALIBRATION_ITERS; ++i)
+  {
+    uint64_t cycles = measure(empty, &input, repeat, NULL);
+    if (cycles < min)
+    {
+      min = cycles;
+    }
+  }
+  return min;
+}
+
+/**
+ * @brief Measures the cycles spent in the timed window by an empty kernel
+ *        (counter reads and indirect call), and the cost of each further
+ *        inner repeat, and the stack used by the driver down to the kernel.
+ *        The overhead is printed, and then subtracted from every sample.
+ */
+static void bench_calibrate(void)
+{
+  static const bench_t empty[] = {
+    [BENCH_INPUT_DOUBLE] = {.name = "Empty", .input_type = BENCH_INPUT_DOUBLE, .run.f64 = empty_f64},
+    [BENCH_INPUT_UINT] = {.name = "Empty", .input_type = BENCH_INPUT_UINT, .run.u32 = empty_u32},
+  };
+  quiet_active = bench_options.quiet;
+  for (uint32_t type = 0; type < 2; ++type)
+  {
+    overhead[type] = measure_empty(&empty[type], 1);
+    uint64_t batch = measure_empty(&empty[type], 17);
+    repeat_overhead[type] = batch > overhead[type] ? (batch - overhead[type]) / 16 : 0;
+  }
+  uint64_t input = 0;
+  bench_stack_paint(bench_arena);
+  measure(&empty[BENCH_INPUT_DOUBLE], &input, 1, NULL);
+  stack_overhead = bench_stack_used();
+  printf("Timer overhead: %lu cycles (double input), %lu cycles (unsigned int input)\r\n",
+         (long unsigned int)overhead[BENCH_INPUT_DOUBLE],
+         (long unsigned int)overhead[BENCH_INPUT_UINT]);
+  printf("Inner repeat overhead: %lu cycles (double input), %lu cycles (unsigned int input)\r\n",
+         (long unsigned int)repeat_overhead[BENCH_INPUT_DOUBLE],
+         (long unsigned int)repeat_overhead[BENCH_INPUT_UINT]);
+  printf("Stack overhead: %lu bytes\r\n", (long unsigned int)stack_overhead);
+}
+
+/**
+ * @brief Generates the input of an iteration from its own seed.
+ *
+ * @param bench: the descriptor of the benchmark
+ * @param input: the buffer of the input
+ * @param index: the index of the iteration in the run
+ */
+static void generate(const bench_t *bench, void *input, uint32_t index)
+{
+  random_set_seed(bench_iteration_seed(bench_options.seed, index));
+  bench->generate(bench, input);
+}
+
+/**
+ * @brief Chooses the number of inner repeats of a benchmark: the one set in
+ *        the registry, or the one that makes the timed window about
+ *        BENCH_TARGET_WINDOW cycles long, based on a pilot call. The pilot
+ *        runs with the tick, so that the cycle clock tracks the wraps of
+ *        CYCCNT; quiet mode stays off for the run if the pilot window times
+ *        the repeats reach BENCH_QUIET_MAX_WINDOW.
+ *
+ * @param bench: the descriptor of the benchmark
+ * @param input: a buffer for the input of the pilot call
+ * @return uint32_t: the number of calls per timed window
+ */
+static uint32_t choose_repeat(const bench_t *bench, void *input)
+{
+  quiet_active = 0;
+  generate(bench, input, 0);
+  uint64_t cycles = measure(bench, input, 1, NULL);
+  uint32_t repeat = bench->repeat;
+  if (repeat == BENCH_REPEAT_AUTO)
+  {
+    repeat = cycles >= BENCH_TARGET_WINDOW ? 1 : BENCH_TARGET_WINDOW / (cycles > 0 ? cycles : 1);
+  }
+  quiet_active = bench_options.quiet;
+  if (quiet_active && cycles * repeat >= BENCH_QUIET_MAX_WINDOW)
+  {
+    quiet_active = 0;
+    printf("Quiet mode off for %s config %lu: windows too long for the cycle clock\r\n",
+           bench->name, (long unsigned int)bench->config);
+  }
+  return repeat;
+}
+
+/**
+ * @brief Removes the overhead of the timed window from a measurement.
+ *
+ * @return uint64_t: the average cycles of one call of the kernel
+ */
+static uint64_t net_cycles(const bench_t *bench, uint64_t cycles, uint32_t repeat)
+{
+  uint64_t cost = overhead[bench->input_type] + (repeat - 1) * repeat_overhead[bench->input_type];
+  return cycles > cost ? (cycles - cost) / repeat : 0;
+}
+
+/**
+ * @brief Runs the warmup iterations of a benchmark and discards their
+ *        samples: bench_options.warmup iterations and, in steady state mode,
+ *        more of them until the coefficient of variation of the last
+ *        BENCH_WINDOW_LEN samples drops below BENCH_STEADY_CV.
+ *
+ * @param bench: the descriptor of the benchmark
+ * @param input: a buffer for the inputs
+ * @param repeat: the number of calls per timed window
+ */
+static void warmup(const bench_t *bench, void *input, uint32_t repeat)
+{
+  bench_window_t window;
+  bench_window_init(&window);
+  uint32_t max = bench_options.warmup;
+  if (bench_options.steady && max < BENCH_STEADY_MAX_WARMUP)
+  {
+    max = BENCH_STEADY_MAX_WARMUP;
+  }
+  uint32_t i = 0;
+  double cv = INFINITY;
+  for (; i < max; ++i)
+  {
+    if (bench_options.steady && i >= bench_options.warmup && cv < BENCH_STEADY_CV)
+    {
+      break;
+    }
+    generate(bench, input, i);
+    bench_window_add(&window, net_cycles(bench, measure(bench, input, repeat, NULL), repeat));
+    cv = bench_window_cv(&window);
+  }
+  if (bench_options.steady)
+  {
+    printf("Warmup: %lu iterations, steady state %s (cv %lu/1000)\r\n", (long unsigned int)i,
+           cv < BENCH_STEADY_CV ? "reached" : "not reached",
+           cv < 1 ? (long unsigned int)(cv * 1000 + 0.5) : 1000UL);
+  }
+  else
+  {
+    printf("Warmup: %lu iterations\r\n", (long unsigned int)i);
+  }
+}
+
+/**
+ * @brief Stack used by the kernel, from a bench_stack_used() measurement.
+ */
+static uint32_t kernel_stack(uint32_t used)
+{
+  return used > stack_overhead ? used - stack_overhead : 0;
+}
+
+/**
+ * @brief Converts cycles at the current system clock to nanoseconds.
+ */
+static uint64_t cycles_to_ns(double cycles)
+{
+  return cycles * 1e9 / SystemCoreClock + 0.5;
+}
+
+/**
+ * @brief Prints the summary line of a run. Values are rounded to the cycle;
+ *        mean_ns is the mean in wall time at the current system clock,
+ *        stack the peak stack use of the kernel, in bytes, and checksum the
+ *        checksum of the outputs of the iterations.
+ */
+static void print_stats(const bench_t *bench, const bench_stats_t *stats, uint32_t stack,
+                        uint32_t checksum)
+{
+  char buf[8][BENCH_U64_STR_LEN];
+  printf("Stats %s config %lu: n=%lu min=%s max=%s mean=%s stddev=%s p50=%s p90=%s p99=%s mean_ns=%s stack=%lu checksum=%08lx\r\n",
+         bench->name, (long unsigned int)bench->config, (long unsigned int)stats->count,
+         bench_u64_str(stats->count ? stats->min : 0, buf[0]),
+         bench_u64_str(stats->max, buf[1]),
+         bench_u64_str(stats->mean + 0.5, buf[2]),
+         bench_u64_str(bench_stats_stddev(stats) + 0.5, buf[3]),
+         bench_u64_str(bench_p2_get(&stats->p50) + 0.5, buf[4]),
+         bench_u64_str(bench_p2_get(&stats->p90) + 0.5, buf[5]),
+         bench_u64_str(bench_p2_get(&stats->p99) + 0.5, buf[6]),
+         bench_u64_str(cycles_to_ns(stats->mean), buf[7]), (long unsigned int)stack,
+         (long unsigned int)checksum);
+}
+
+/**
+ * @brief Size of the input of a benchmark, in bytes.
+ */
+static uint32_t input_bytes(const bench_t *bench)
+{
+  uint32_t elem_size = bench->input_type == BENCH_INPUT_DOUBLE ? sizeof(double) : sizeof(unsigned int);
+  return bench->input_len * elem_size;
+}
+
+/**
+ * @brief Checks that the input of the benchmark fits the arena, and applies
+ *        the parameters of the benchmark to its kernel.
+ *
+ * @return int: 0 on success, -1 if the input is too big or the kernel
+ *         rejected the parameters
+ */
+static int configure(const bench_t *bench)
+{
+  if (input_bytes(bench) > bench_arena_size)
+  {
+    printf("Input of %s config %lu does not fit the arena\r\n", bench->name,
+           (long unsigned int)bench->config);
+    return -1;
+  }
+  if (bench->configure != NULL && bench->configure(bench) != 0)
+  {
+    printf("Invalid config %lu of %s\r\n", (long unsigned int)bench->config, bench->name);
+    return -1;
+  }
+  return 0;
+}
+
+/**
+ * @brief Checks that the stack of the kernel did not reach its input since
+ *        the last bench_stack_paint(), which would have corrupted it.
+ *
+ * @return int: 0 on success, -1 if the stack reached the input
+ */
+static int check_stack(const bench_t *bench)
+{
+  if (!bench_stack_overrun())
+  {
+    return 0;
+  }
+  printf("Stack of %s config %lu reached its input\r\n", bench->name,
+         (long unsigned int)bench->config);
+  return -1;
+}
+
+/**
+ * @brief Chooses the inner repeats of a run and warms the kernel up.
+ *
+ * @return uint32_t: the number of calls per timed window
+ */
+static uint32_t prepare(const bench_t *bench, void *input)
+{
+  printf("Seed: %lu\r\n", (long unsigned int)bench_options.seed);
+  uint32_t repeat = choose_repeat(bench, input);
+  printf("Inner repeats: %lu\r\n", (long unsigned int)repeat);
+  drain_output();
+  warmup(bench, input, repeat);
+  return repeat;
+}
+
+/**
+ * @brief Runs the given benchmark.
+ *
+ * @param bench: the descriptor of the benchmark
+ * @param iter: the number of iterations: each iteration will have different input
+ * @param result: where to copy the statistics of the run, or NULL
+ * @return int: 0 on success, -1 if the configuration was rejected or the
+ *         stack of the kernel reached its input
+ */
+int bench_run(const bench_t *bench, uint32_t iter, bench_stats_t *result)
+{
+  if (configure(bench) != 0)
+  {
+    return -1;
+  }
+  void *input = bench_arena;
+  uint32_t n_samples = 0, first = 0;
+  bench_stats_t stats;
+  bench_stats_init(&stats);
+  uint32_t repeat = prepare(bench, input);
+  uint32_t stack = 0, used;
+  uint32_t checksum = BENCH_CHECKSUM_INIT;
+  quiet_suppressed = 0;
+  quiet_leaked = 0;
+#if BENCH_PC_PROFILE
+  bench_pcprof_reset();
+#endif
+  drain_output();
+  // Only generate, measure and the kernel run on the painted stack: the
+  // output code is kept out of it
+  void *input_end = (uint8_t *)input + input_bytes(bench);
+  bench_stack_paint(input_end);
+  for (uint32_t i = 0; i < iter; ++i)
+  {
+    // Randomize array
+    generate(bench, input, i);
+    bench_profile_t *profile = bench_options.profile ? &profiles[n_samples] : NULL;
+    uint64_t cycles = measure(bench, input, repeat, profile);
+    checksum = bench_fold_checksum(checksum, sink);
+    samples[n_samples] = net_cycles(bench, cycles, repeat);
+    bench_stats_add(&stats, samples[n_samples]);
+    ++n_samples;
+    if (n_samples == BENCH_MAX_SAMPLES)
+    {
+      if (check_stack(bench) != 0)
+      {
+        return -1;
+      }
+      used = bench_stack_used();
+      stack = used > stack ? used : stack;
+      if (bench_options.raw)
+      {
+        bench_output_samples(bench, first, samples, bench_options.profile ? profiles : NULL, n_samples);
+        drain_output();
+      }
+      bench_stack_paint(input_end);
+      first += n_samples;
+      n_samples = 0;
+    }
+  }
+  if (check_stack(bench) != 0)
+  {
+    return -1;
+  }
+  used = bench_stack_used();
+  stack = used > stack ? used : stack;
+  if (bench_options.raw)
+  {
+    bench_output_samples(bench, first, samples, bench_options.profile ? profiles : NULL, n_samples);
+  }
+  print_stats(bench, &stats, kernel_stack(stack), checksum);
+#if BENCH_PC_PROFILE
+  bench_pcprof_report(bench);
+#endif
+  if (result != NULL)
+  {
+    *result = stats;
+  }
+  if (quiet_active)
+  {
+    printf("Quiet mode: %lu interrupts suppressed, %lu windows with exceptions\r\n",
+           (long unsigned int)quiet_suppressed, (long unsigned int)quiet_leaked);
+  }
+  return 0;
+}
+
+/**
+ * @brief Regenerates the input of a single iteration of a run from its seed
+ *        and times it again, to reproduce an outlier without replaying the
+ *        iterations before it. Inner repeats and warmup are the same as in
+ *        bench_run().
+ *
+ * @param bench: the descriptor of the benchmark
+ * @param index: the index of the iteration in the run
+ * @param times: the number of measurements of the iteration
+ * @return int: 0 on success, -1 if the configuration was rejected or the
+ *         stack of the kernel reached its input
+ */
+int bench_replay(const bench_t *bench, uint32_t index, uint32_t times)
+{
+  char buf[BENCH_U64_STR_LEN];
+  if (configure(bench) != 0)
+  {
+    return -1;
+  }
+  void *input = bench_arena;
+  bench_stats_t stats;
+  bench_stats_init(&stats);
+  uint32_t repeat = prepare(bench, input);
+  uint32_t seed = bench_iteration_seed(bench_options.seed, index);
+  uint32_t stack = 0;
+  generate(bench, input, index);
+#if BENCH_PC_PROFILE
+  bench_pcprof_reset();
+#endif
+  for (uint32_t i = 0; i < times; ++i)
+  {
+    bench_stack_paint((uint8_t *)input + input_bytes(bench));
+    uint64_t cycles = net_cycles(bench, measure(bench, input, repeat, NULL), repeat);
+    if (check_stack(bench) != 0)
+    {
+      return -1;
+    }
+    uint32_t used = bench_stack_used();
+    stack = used > stack ? used : stack;
+    bench_stats_add(&stats, cycles);
+    printf("Replay %s config %lu iteration %lu seed %lu: %s\r\n", bench->name,
+           (long unsigned int)bench->config, (long unsigned int)index,
+           (long unsigned int)seed, bench_u64_str(cycles, buf));
+    drain_output();
+  }
+  // The checksum of the iteration alone, as the output does not change
+  print_stats(bench, &stats, kernel_stack(stack), sink);
+#if BENCH_PC_PROFILE
+  bench_pcprof_report(bench);
+#endif
+  return 0;
+}
+
+/**
+ * @brief Runs all the benchmarks of the registry, in order.
+ *
+ * @param iter: the number of iterations of each benchmark
+ */
+void bench_run_all(uint32_t iter)
+{
+  char buf[2][BENCH_U64_STR_LEN];
+  uint64_t start = cycle_clock_now();
+  for (uint32_t i = 0; i < bench_registry_len; ++i)
+  {
+    const bench_t *bench = &bench_registry[i];
+    printf("Start bench %s config %lu\r\n", bench->name, (long unsigned int)bench->config);
+    bench_run(bench, iter, NULL);
+    printf("Done bench %s config %lu\r\n", bench->name, (long unsigned int)bench->config);
+  }
+  uint64_t cycles = cycle_clock_now() - start;
+  printf("Suite cycles: %s (%s us)\r\n", bench_u64_str(cycles, buf[0]),
+         bench_u64_str(cycles_to_ns(cycles) / 1000, buf[1]));
+}
@@ -0,0 +1,189 @@
+/**
+ * @file bench_clock.c
+ * @brief System clock sweep of the benchmark suite.
+ */
+
+#include <stdio.h>
+#include "main.h"
+#include "usart.h"
+#include "bench.h"
+#include "bench_clock.h"
+#include "uart_tx.h"
+
+// Maximum frequency of each voltage range: 32 MHz (range 1), 16 MHz
+// (range 2) and 4.2 MHz (range 3). One wait state is needed above 16, 8 and
+// 2.1 MHz respectively; the HSI and the PLL are not available in range 3.
+const bench_clock_t bench_clocks[] = {
+  {
+    .name = "MSI 2.097 MHz",
+    .sysclk_source = RCC_SYSCLKSOURCE_MSI,
+    .msi_range = RCC_MSIRANGE_5,
+    .voltage_scale = PWR_REGULATOR_VOLTAGE_SCALE3,
+    .flash_latency = FLASH_LATENCY_0,
+  },
+  {
+    .name = "MSI 4.194 MHz",
+    .sysclk_source = RCC_SYSCLKSOURCE_MSI,
+    .msi_range = RCC_MSIRANGE_6,
+    .voltage_scale = PWR_REGULATOR_VOLTAGE_SCALE3,
+    .flash_latency = FLASH_LATENCY_1,
+  },
+  {
+    .name = "HSI 16 MHz 0 WS",
+    .sysclk_source = RCC_SYSCLKSOURCE_HSI,
+    .voltage_scale = PWR_REGULATOR_VOLTAGE_SCALE1,
+    .flash_latency = FLASH_LATENCY_0,
+  },
+  {
+    .name = "HSI 16 MHz 1 WS",
+    .sysclk_source = RCC_SYSCLKSOURCE_HSI,
+    .voltage_scale = PWR_REGULATOR_VOLTAGE_SCALE1,
+    .flash_latency = FLASH_LATENCY_1,
+  },
+  {
+    .name = "PLL 16 MHz",
+    .sysclk_source = RCC_SYSCLKSOURCE_PLLCLK,
+    .pll_mul = RCC_PLL_MUL3,
+    .pll_div = RCC_PLL_DIV3,
+    .voltage_scale = PWR_REGULATOR_VOLTAGE_SCALE2,
+    .flash_latency = FLASH_LATENCY_1,
+  },
+  // The configuration of SystemClock_Config(), last so that the sweep ends
+  // with the clock the firmware boots with
+  {
+    .name = "PLL 32 MHz",
+    .sysclk_source = RCC_SYSCLKSOURCE_PLLCLK,
+    .pll_mul = RCC_PLL_MUL6,
+    .pll_div = RCC_PLL_DIV3,
+    .voltage_scale = PWR_REGULATOR_VOLTAGE_SCALE1,
+    .flash_latency = FLASH_LATENCY_1,
+  },
+};
+
+const uint32_t bench_clocks_len = sizeof(bench_clocks) / sizeof(bench_clocks[0]);
+
+/**
+ * @brief Sets the voltage range of the regulator and waits until it is
+ *        stable.
+ */
+static void set_voltage_scale(uint32_t scale)
+{
+  __HAL_PWR_VOLTAGESCALING_CONFIG(scale);
+  while (__HAL_PWR_GET_FLAG(PWR_FLAG_VOS))
+  {
+  }
+}
+
+/**
+ * @brief Selects the source of the system clock, with all the bus clocks
+ *        undivided.
+ */
+static HAL_StatusTypeDef set_sysclk(uint32_t source, uint32_t latency)
+{
+  RCC_ClkInitTypeDef clk = {0};
+  clk.ClockType = RCC_CLOCKTYPE_HCLK | RCC_CLOCKTYPE_SYSCLK | RCC_CLOCKTYPE_PCLK1 | RCC_CLOCKTYPE_PCLK2;
+  clk.SYSCLKSource = source;
+  clk.AHBCLKDivider = RCC_SYSCLK_DIV1;
+  clk.APB1CLKDivider = RCC_HCLK_DIV1;
+  clk.APB2CLKDivider = RCC_HCLK_DIV1;
+  return HAL_RCC_ClockConfig(&clk, latency);
+}
+
+/**
+ * @brief Switches the oscillators, the system clock, the flash latency and
+ *        the voltage range to the given configuration.
+ */
+static HAL_StatusTypeDef apply(const bench_clock_t *clock)
+{
+  RCC_OscInitTypeDef osc = {0};
+  // Move to the HSI at range 1, where every oscillator can be configured
+  set_voltage_scale(PWR_REGULATOR_VOLTAGE_SCALE1);
+  osc.OscillatorType = RCC_OSCILLATORTYPE_HSI;
+  osc.HSIState = RCC_HSI_ON;
+  osc.HSICalibrationValue = RCC_HSICALIBRATION_DEFAULT;
+  osc.PLL.PLLState = RCC_PLL_NONE;
+  if (HAL_RCC_OscConfig(&osc) != HAL_OK || set_sysclk(RCC_SYSCLKSOURCE_HSI, FLASH_LATENCY_1) != HAL_OK)
+  {
+    return HAL_ERROR;
+  }
+  // Configure the oscillator of the target
+  osc.OscillatorType = RCC_OSCILLATORTYPE_NONE;
+  if (clock->sysclk_source == RCC_SYSCLKSOURCE_MSI)
+  {
+    osc.OscillatorType = RCC_OSCILLATORTYPE_MSI;
+    osc.MSIState = RCC_MSI_ON;
+    osc.MSICalibrationValue = RCC_MSICALIBRATION_DEFAULT;
+    osc.MSIClockRange = clock->msi_range;
+  }
+  else if (clock->sysclk_source == RCC_SYSCLKSOURCE_PLLCLK)
+  {
+    osc.PLL.PLLState = RCC_PLL_ON;
+    osc.PLL.PLLSource = RCC_PLLSOURCE_HSI;
+    osc.PLL.PLLMUL = clock->pll_mul;
+    osc.PLL.PLLDIV = clock->pll_div;
+  }
+  if (HAL_RCC_OscConfig(&osc) != HAL_OK || set_sysclk(clock->sysclk_source, clock->flash_latency) != HAL_OK)
+  {
+    return HAL_ERROR;
+  }
+  if (clock->sysclk_source == RCC_SYSCLKSOURCE_MSI)
+  {
+    // The PLL and the HSI are not available in range 3
+    osc.OscillatorType = RCC_OSCILLATORTYPE_NONE;
+    osc.PLL.PLLState = RCC_PLL_OFF;
+    if (HAL_RCC_OscConfig(&osc) != HAL_OK)
+    {
+      return HAL_ERROR;
+    }
+    osc.OscillatorType = RCC_OSCILLATORTYPE_HSI;
+    osc.HSIState = RCC_HSI_OFF;
+    osc.PLL.PLLState = RCC_PLL_NONE;
+    if (HAL_RCC_OscConfig(&osc) != HAL_OK)
+    {
+      return HAL_ERROR;
+    }
+  }
+  set_voltage_scale(clock->voltage_scale);
+  return HAL_OK;
+}
+
+/**
+ * @brief Applies a clock configuration: the pending output is sent first,
+ *        and the UART and the HAL tick follow the new clock.
+ *
+ * @param clock: the configuration
+ * @return int: 0 on success, -1 on error (the system may be left on the HSI)
+ */
+int bench_clock_set(const bench_clock_t *clock)
+{
+  fflush(stdout);
+  uart_tx_flush();
+  HAL_StatusTypeDef status = apply(clock);
+  // Recompute the baud rate from the new PCLK1
+  HAL_UART_DeInit(&huart2);
+  MX_USART2_UART_Init();
+  return status == HAL_OK ? 0 : -1;
+}
+
+/**
+ * @brief Runs the suite under every clock configuration of bench_clocks. The
+ *        overhead of the timed window is measured again under each of them.
+ *
+ * @param iter: the number of iterations of each benchmark
+ */
+void bench_clock_sweep(uint32_t iter)
+{
+  for (uint32_t i = 0; i < bench_clocks_len; ++i)
+  {
+    const bench_clock_t *clock = &bench_clocks[i];
+    if (bench_clock_set(clock) != 0)
+    {
+      printf("Clock: %s could not be set\r\n", clock->name);
+      continue;
+    }
+    printf("Clock: %s, %lu Hz, %lu wait states\r\n", clock->name,
+           (long unsigned int)SystemCoreClock, (long unsigned int)clock->flash_latency);
+    bench_init();
+    bench_run_all(iter);
+  }
+}
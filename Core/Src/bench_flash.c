@@ -0,0 +1,148 @@
+/**
+ * @file bench_flash.c
+ * @brief Flash accelerator sweep of the benchmark suite.
+ */
+
+#include <stdio.h>
+#include "main.h"
+#include "bench.h"
+#include "bench_clock.h"
+#include "bench_flash.h"
+#include "bench_output.h"
+
+// The first setting is the reference of the comparison
+const bench_flash_t bench_flash_settings[] = {
+  {.prefetch = 0, .acc64 = 0, .latency = 0},
+  {.prefetch = 0, .acc64 = 1, .latency = 0},
+  {.prefetch = 1, .acc64 = 1, .latency = 0},
+  {.prefetch = 0, .acc64 = 1, .latency = 1},
+  {.prefetch = 1, .acc64 = 1, .latency = 1},
+};
+
+const uint32_t bench_flash_settings_len = sizeof(bench_flash_settings) / sizeof(bench_flash_settings[0]);
+
+/**
+ * @brief Highest system clock frequency that allows 0 wait states in the
+ *        current voltage range.
+ */
+static uint32_t max_zero_wait_hz(void)
+{
+  switch (PWR->CR & PWR_CR_VOS)
+  {
+  case PWR_REGULATOR_VOLTAGE_SCALE1:
+    return 16000000;
+  case PWR_REGULATOR_VOLTAGE_SCALE2:
+    return 8000000;
+  default:
+    return 2097152;
+  }
+}
+
+/**
+ * @brief Programs the flash accelerator. The 64-bit access is enabled first
+ *        and disabled last, since the latency and the prefetch need it.
+ *
+ * @param flash: the setting
+ * @return int: 0 on success, -1 if the setting is not valid or not allowed
+ *         at the current system clock
+ */
+int bench_flash_set(const bench_flash_t *flash)
+{
+  if ((!flash->acc64 && (flash->prefetch || flash->latency)) ||
+      (flash->latency == 0 && SystemCoreClock > max_zero_wait_hz()))
+  {
+    return -1;
+  }
+  __HAL_FLASH_ACC64_ENABLE();
+  __HAL_FLASH_SET_LATENCY(flash->latency ? FLASH_LATENCY_1 : FLASH_LATENCY_0);
+  if (flash->prefetch)
+  {
+    __HAL_FLASH_PREFETCH_BUFFER_ENABLE();
+  }
+  else
+  {
+    __HAL_FLASH_PREFETCH_BUFFER_DISABLE();
+  }
+  if (!flash->acc64)
+  {
+    __HAL_FLASH_ACC64_DISABLE();
+  }
+  return 0;
+}
+
+/**
+ * @brief Runs every benchmark of the registry under each flash setting
+ *        allowed at clock BENCH_FLASH_SWEEP_CLOCK, and reports the mean
+ *        cycles of each setting and their difference from the first one.
+ *        The boot clock and flash setting are restored at the end.
+ *
+ * @param iter: the number of iterations of each run
+ */
+void bench_flash_sweep(uint32_t iter)
+{
+  char buf[BENCH_U64_STR_LEN];
+  uint32_t boot_prefetch = READ_BIT(FLASH->ACR, FLASH_ACR_PRFTEN);
+  const bench_clock_t *clock = &bench_clocks[BENCH_FLASH_SWEEP_CLOCK];
+  if (bench_clock_set(clock) != 0)
+  {
+    printf("Clock: %s could not be set\r\n", clock->name);
+    return;
+  }
+  printf("Clock: %s, %lu Hz\r\n", clock->name, (long unsigned int)SystemCoreClock);
+  bench_stats_t stats;
+  uint64_t mean[bench_flash_settings_len];
+  // Settings that could be applied and whose run succeeded
+  uint8_t valid[bench_flash_settings_len];
+  for (uint32_t i = 0; i < bench_registry_len; ++i)
+  {
+    const bench_t *bench = &bench_registry[i];
+    for (uint32_t f = 0; f < bench_flash_settings_len; ++f)
+    {
+      const bench_flash_t *flash = &bench_flash_settings[f];
+      valid[f] = 0;
+      if (bench_flash_set(flash) != 0)
+      {
+        continue;
+      }
+      printf("Flash: prefetch %u, 64-bit %u, latency %u\r\n", flash->prefetch, flash->acc64,
+             flash->latency);
+      // The overhead of the timed window depends on the setting as well
+      bench_init();
+      printf("Start bench %s config %lu\r\n", bench->name, (long unsigned int)bench->config);
+      if (bench_run(bench, iter, &stats) == 0)
+      {
+        mean[f] = stats.mean + 0.5;
+        valid[f] = 1;
+      }
+      printf("Done bench %s config %lu\r\n", bench->name, (long unsigned int)bench->config);
+    }
+    for (uint32_t f = 0; f < bench_flash_settings_len; ++f)
+    {
+      const bench_flash_t *flash = &bench_flash_settings[f];
+      if (!valid[f])
+      {
+        continue;
+      }
+      printf("Flash %s config %lu: prefetch=%u acc64=%u latency=%u mean=%s", bench->name,
+             (long unsigned int)bench->config, flash->prefetch, flash->acc64, flash->latency,
+             bench_u64_str(mean[f], buf));
+      // No delta without the reference setting
+      if (valid[0])
+      {
+        printf(" delta=%ld", (long int)(mean[f] - mean[0]));
+      }
+      printf("\r\n");
+    }
+  }
+  // Back to the boot configuration, the last entry of the clock table
+  bench_clock_set(&bench_clocks[bench_clocks_len - 1]);
+  if (boot_prefetch)
+  {
+    __HAL_FLASH_PREFETCH_BUFFER_ENABLE();
+  }
+  else
+  {
+    __HAL_FLASH_PREFETCH_BUFFER_DISABLE();
+  }
+  bench_init();
+}
@@ -0,0 +1,217 @@
+/**
+ * @file bench_output.c
+ * @brief Text and binary reporting of the benchmark samples. See
+ * bench_output.h for the layout of the binary frames.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "bench_output.h"
+
+// Header (magic, length, type, config, name length), name (at most 255
+// chars), first index, count, samples and CRC
+#define FRAME_MAX_LEN (7 + 255 + 6 + 8 * BENCH_FRAME_MAX_SAMPLES + 4)
+
+static uint8_t frame[FRAME_MAX_LEN];
+
+static uint8_t *put_u16(uint8_t *p, uint16_t v)
+{
+  p[0] = v & 0xFF;
+  p[1] = v >> 8;
+  return p + 2;
+}
+
+static uint8_t *put_u32(uint8_t *p, uint32_t v)
+{
+  p[0] = v & 0xFF;
+  p[1] = (v >> 8) & 0xFF;
+  p[2] = (v >> 16) & 0xFF;
+  p[3] = v >> 24;
+  return p + 4;
+}
+
+static uint8_t *put_u64(uint8_t *p, uint64_t v)
+{
+  p = put_u32(p, v & 0xFFFFFFFF);
+  return put_u32(p, v >> 32);
+}
+
+/**
+ * @brief Formats an unsigned 64-bit value in decimal (newlib-nano's printf
+ *        does not support %llu).
+ *
+ * @param value: the value to format
+ * @param buf: the output buffer
+ * @return char*: the formatted string, inside buf
+ */
+char *bench_u64_str(uint64_t value, char buf[BENCH_U64_STR_LEN])
+{
+  char *p = &buf[BENCH_U64_STR_LEN - 1];
+  *p = '\0';
+  do
+  {
+    *--p = '0' + value % 10;
+    value /= 10;
+  } while (value != 0);
+  return p;
+}
+
+/**
+ * @brief Updates a CRC-32 (IEEE 802.3, reflected, polynomial 0xEDB88320).
+ *        Start with crc = 0; the result is the same as zlib's crc32().
+ *
+ * @param crc: the CRC of the previous data
+ * @param data: the data to add
+ * @param len: the length of the data
+ * @return uint32_t: the updated CRC
+ */
+uint32_t bench_crc32(uint32_t crc, const uint8_t *data, uint32_t len)
+{
+  crc = ~crc;
+  for (uint32_t i = 0; i < len; ++i)
+  {
+    crc ^= data[i];
+    for (int bit = 0; bit < 8; ++bit)
+    {
+      crc = (crc >> 1) ^ (0xEDB88320 & -(crc & 1));
+    }
+  }
+  return ~crc;
+}
+
+/**
+ * @brief Writes the header of a frame, up to the sample count.
+ *
+ * @return uint8_t*: where the first sample goes
+ */
+static uint8_t *begin_frame(const bench_t *bench, uint8_t type, uint32_t sample_len,
+                            uint32_t first, uint32_t count)
+{
+  uint32_t name_len = strlen(bench->name);
+  if (name_len > 255)
+  {
+    name_len = 255;
+  }
+  uint8_t *p = frame;
+  *p++ = BENCH_FRAME_MAGIC_0;
+  *p++ = BENCH_FRAME_MAGIC_1;
+  p = put_u16(p, 3 + name_len + 6 + sample_len * count);
+  *p++ = type;
+  *p++ = bench->config;
+  *p++ = name_len;
+  memcpy(p, bench->name, name_len);
+  p += name_len;
+  p = put_u32(p, first);
+  return put_u16(p, count);
+}
+
+/**
+ * @brief Appends the CRC to the frame that ends at p, and sends it.
+ */
+static void end_frame(uint8_t *p)
+{
+  // The body starts after the magic and the length
+  p = put_u32(p, bench_crc32(0, frame + 4, p - (frame + 4)));
+  fwrite(frame, 1, p - frame, stdout);
+}
+
+/**
+ * @brief Sends the cycle counts of up to BENCH_FRAME_MAX_SAMPLES iterations.
+ */
+static void send_samples(const bench_t *bench, uint32_t first,
+                         const uint64_t *samples, uint32_t count)
+{
+  uint8_t type = BENCH_FRAME_SAMPLES_U32;
+  uint32_t sample_len = 4;
+  for (uint32_t i = 0; i < count; ++i)
+  {
+    if (samples[i] > UINT32_MAX)
+    {
+      type = BENCH_FRAME_SAMPLES_U64;
+      sample_len = 8;
+      break;
+    }
+  }
+  uint8_t *p = begin_frame(bench, type, sample_len, first, count);
+  for (uint32_t i = 0; i < count; ++i)
+  {
+    if (type == BENCH_FRAME_SAMPLES_U64)
+    {
+      p = put_u64(p, samples[i]);
+    }
+    else
+    {
+      p = put_u32(p, samples[i]);
+    }
+  }
+  end_frame(p);
+}
+
+/**
+ * @brief Sends the profiling counters of up to BENCH_FRAME_MAX_SAMPLES
+ *        iterations.
+ */
+static void send_profiles(const bench_t *bench, uint32_t first,
+                          const bench_profile_t *profiles, uint32_t count)
+{
+  uint8_t *p = begin_frame(bench, BENCH_FRAME_PROFILE, 5, first, count);
+  for (uint32_t i = 0; i < count; ++i)
+  {
+    *p++ = profiles[i].cpi;
+    *p++ = profiles[i].exc;
+    *p++ = profiles[i].sleep;
+    *p++ = profiles[i].lsu;
+    *p++ = profiles[i].fold;
+  }
+  end_frame(p);
+}
+
+/**
+ * @brief Reports a block of samples of a benchmark, in the format selected
+ *        by bench_options.output.
+ *
+ * @param bench: the benchmark the samples belong to
+ * @param first: the iteration index of the first sample
+ * @param samples: the cycle counts
+ * @param profiles: the profiling counters, or NULL if not profiling
+ * @param count: the number of samples
+ */
+void bench_output_samples(const bench_t *bench, uint32_t first,
+                          const uint64_t *samples,
+                          const bench_profile_t *profiles, uint32_t count)
+{
+  if (bench_options.output == BENCH_OUTPUT_BINARY)
+  {
+    while (count > 0)
+    {
+      uint32_t n = count < BENCH_FRAME_MAX_SAMPLES ? count : BENCH_FRAME_MAX_SAMPLES;
+      send_samples(bench, first, samples, n);
+      if (profiles != NULL)
+      {
+        send_profiles(bench, first, profiles, n);
+        profiles += n;
+      }
+      first += n;
+      samples += n;
+      count -= n;
+    }
+  }
+  else
+  {
+    char buf[BENCH_U64_STR_LEN];
+    for (uint32_t i = 0; i < count; ++i)
+    {
+      if (profiles != NULL)
+      {
+        printf("%s,%u,%u,%u,%u,%u\r\n", bench_u64_str(samples[i], buf),
+               profiles[i].cpi, profiles[i].exc, profiles[i].sleep,
+               profiles[i].lsu, profiles[i].fold);
+      }
+      else
+      {
+        printf("%s\r\n", bench_u64_str(samples[i], buf));
+      }
+    }
+  }
+  fflush(stdout);
+}
@@ -0,0 +1,134 @@
+/**
+ * @file bench_pcprof.c
+ * @brief PC-sampling profiler driven by TIM6.
+ *
+ * The table is an open addressing hash table, indexed by a multiplicative
+ * hash of the PC and probed linearly. A slot is free while its count is 0.
+ */
+
+#include <stdio.h>
+#include "main.h"
+#include "bench_pcprof.h"
+
+#if BENCH_PC_PROFILE
+
+#define SLOT_MASK (BENCH_PC_PROFILE_SLOTS - 1)
+
+static uint32_t pcs[BENCH_PC_PROFILE_SLOTS];
+static uint16_t counts[BENCH_PC_PROFILE_SLOTS];
+static volatile uint32_t total;   // Samples taken since the last reset
+static volatile uint32_t dropped; // Samples not recorded, the table being full
+
+/**
+ * @brief Records the PC stacked by the timer interrupt.
+ *
+ * @param frame: the exception stack frame (r0-r3, r12, lr, pc, xpsr)
+ */
+__attribute__((used)) static void record_sample(const uint32_t *frame)
+{
+  TIM6->SR = 0;
+  uint32_t pc = frame[6];
+  uint32_t slot = ((pc >> 1) * 2654435761u) & SLOT_MASK;
+  ++total;
+  for (uint32_t probe = 0; probe < BENCH_PC_PROFILE_SLOTS; ++probe)
+  {
+    if (counts[slot] == 0)
+    {
+      pcs[slot] = pc;
+    }
+    if (pcs[slot] == pc)
+    {
+      // Saturate rather than free the slot
+      if (counts[slot] != UINT16_MAX)
+      {
+        ++counts[slot];
+      }
+      return;
+    }
+    slot = (slot + 1) & SLOT_MASK;
+  }
+  ++dropped;
+}
+
+/**
+ * @brief Passes the stack frame of the interrupted code, on the main or the
+ *        process stack, to record_sample().
+ */
+__attribute__((naked)) void TIM6_IRQHandler(void)
+{
+  __asm volatile("tst lr, #4\n"
+                 "ite eq\n"
+                 "mrseq r0, msp\n"
+                 "mrsne r0, psp\n"
+                 "b record_sample\n");
+}
+
+/**
+ * @brief Sets TIM6 up to interrupt every BENCH_PC_PROFILE_PERIOD cycles,
+ *        stopped until bench_pcprof_resume().
+ */
+void bench_pcprof_init(void)
+{
+  __HAL_RCC_TIM6_CLK_ENABLE();
+  TIM6->CR1 = 0;
+  TIM6->PSC = 0;
+  TIM6->ARR = BENCH_PC_PROFILE_PERIOD - 1;
+  // Load the registers, then discard the update flag set by it
+  TIM6->EGR = TIM_EGR_UG;
+  TIM6->SR = 0;
+  TIM6->DIER = TIM_DIER_UIE;
+  HAL_NVIC_SetPriority(TIM6_IRQn, 0, 0);
+  HAL_NVIC_EnableIRQ(TIM6_IRQn);
+}
+
+/**
+ * @brief Empties the table.
+ */
+void bench_pcprof_reset(void)
+{
+  for (uint32_t i = 0; i < BENCH_PC_PROFILE_SLOTS; ++i)
+  {
+    counts[i] = 0;
+  }
+  total = 0;
+  dropped = 0;
+}
+
+/**
+ * @brief Starts sampling, from where the last bench_pcprof_pause() stopped
+ *        the timer.
+ */
+void bench_pcprof_resume(void)
+{
+  TIM6->CR1 |= TIM_CR1_CEN;
+}
+
+/**
+ * @brief Stops sampling.
+ */
+void bench_pcprof_pause(void)
+{
+  TIM6->CR1 &= ~TIM_CR1_CEN;
+}
+
+/**
+ * @brief Sends the table (see bench_pcprof.h for the format).
+ *
+ * @param bench: the benchmark the samples belong to
+ */
+void bench_pcprof_report(const bench_t *bench)
+{
+  printf("PC profile %s config %lu: %lu samples, %lu dropped, period %lu cycles\r\n",
+         bench->name, (long unsigned int)bench->config, (long unsigned int)total,
+         (long unsigned int)dropped, (long unsigned int)BENCH_PC_PROFILE_PERIOD);
+  for (uint32_t i = 0; i < BENCH_PC_PROFILE_SLOTS; ++i)
+  {
+    if (counts[i] != 0)
+    {
+      printf("PC 0x%08lx %u\r\n", (long unsigned int)pcs[i], counts[i]);
+    }
+  }
+  printf("PC profile end\r\n");
+}
+
+#endif
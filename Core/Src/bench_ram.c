@@ -0,0 +1,61 @@
+/**
+ * @file bench_ram.c
+ * @brief Comparison of the kernels run from flash and from RAM.
+ */
+
+#include <stdio.h>
+#include "bench.h"
+#include "bench_ram.h"
+#include "bench_output.h"
+
+// Bounds of the .RamFunc sections, copied to RAM by the startup code
+extern uint8_t _sramfunc;
+extern uint8_t _eramfunc;
+
+/**
+ * @brief Runs a benchmark with the given placement of its kernel.
+ *
+ * @return uint64_t: the mean cycles, rounded, or 0 if the run failed
+ */
+static uint64_t run_placement(const bench_t *bench, const char *placement, uint32_t iter)
+{
+  bench_stats_t stats;
+  printf("Placement: %s\r\n", placement);
+  printf("Start bench %s config %lu\r\n", bench->name, (long unsigned int)bench->config);
+  int status = bench_run(bench, iter, &stats);
+  printf("Done bench %s config %lu\r\n", bench->name, (long unsigned int)bench->config);
+  return status == 0 ? stats.mean + 0.5 : 0;
+}
+
+/**
+ * @brief Runs every benchmark of the registry with its kernel in flash and
+ *        in RAM, and reports the speedup of the RAM placement. The RAM cost
+ *        is the size of all the .RamFunc sections; the link map has the
+ *        size of each kernel (.RamFunc.<kernel>).
+ *
+ * @param iter: the number of iterations of each run
+ */
+void bench_ram_compare(uint32_t iter)
+{
+  char buf[2][BENCH_U64_STR_LEN];
+  printf("RAM functions: %lu bytes\r\n", (long unsigned int)(&_eramfunc - &_sramfunc));
+  for (uint32_t i = 0; i < bench_registry_len; ++i)
+  {
+    const bench_t *bench = &bench_registry[i];
+    if (bench->run_ram.f64 == NULL)
+    {
+      continue;
+    }
+    bench_t ram = *bench;
+    ram.run = bench->run_ram;
+    ram.configure = bench->configure_ram;
+    uint64_t flash_mean = run_placement(bench, "flash", iter);
+    uint64_t ram_mean = run_placement(&ram, "RAM", iter);
+    // Speedup in hundredths: newlib-nano's printf has no floating point
+    uint32_t speedup = ram_mean != 0 ? (flash_mean * 100 + ram_mean / 2) / ram_mean : 0;
+    printf("RAM %s config %lu: flash=%s ram=%s speedup=%lu.%02lu\r\n", bench->name,
+           (long unsigned int)bench->config, bench_u64_str(flash_mean, buf[0]),
+           bench_u64_str(ram_mean, buf[1]), (long unsigned int)(speedup / 100),
+           (long unsigned int)(speedup % 100));
+  }
+}
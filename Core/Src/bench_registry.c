@@ -0,0 +1,228 @@
+/**
+ * @file bench_registry.c
+ * @brief Table of the benchmarks run by the firmware, and the input
+ * generators they use.
+ */
+
+#include <stddef.h>
+#include "bench.h"
+#include "simple_random.h"
+#include "visualizer.h"
+#include "pwm-fan-speed.h"
+#include "huffman-compression.h"
+#include "pathfind.h"
+
+// Copy of the kernel placed in RAM, when built
+#if BENCH_RAM_KERNELS
+#define RAM_COPY(fn) fn##_ram
+#else
+#define RAM_COPY(fn) NULL
+#endif
+
+static int configure_visualizer(const bench_t *bench)
+{
+  return visualizer_configure(bench->params);
+}
+
+static int configure_pwm(const bench_t *bench)
+{
+  return pwm_configure(bench->params);
+}
+
+static int configure_huffman(const bench_t *bench)
+{
+  return huffman_configure(bench->params);
+}
+
+static int configure_pathfind(const bench_t *bench)
+{
+  return pathfind_configure(bench->params);
+}
+
+#if BENCH_RAM_KERNELS
+static int configure_visualizer_ram(const bench_t *bench)
+{
+  return visualizer_configure_ram(bench->params);
+}
+
+static int configure_pwm_ram(const bench_t *bench)
+{
+  return pwm_configure_ram(bench->params);
+}
+
+static int configure_huffman_ram(const bench_t *bench)
+{
+  return huffman_configure_ram(bench->params);
+}
+
+static int configure_pathfind_ram(const bench_t *bench)
+{
+  return pathfind_configure_ram(bench->params);
+}
+#endif
+
+// Registry entries, one per configuration of each kernel
+
+#define VIS_BENCH(id, w, h, size)                                            \
+  {                                                                          \
+    .name = "Visualizer",                                                    \
+    .short_name = "visualizer",                                              \
+    .config = id,                                                            \
+    .input_type = BENCH_INPUT_DOUBLE,                                        \
+    .input_len = size,                                                       \
+    .generate = bench_gen_double,                                            \
+    .scale = 100,                                                            \
+    .params = &(const vis_config_t){.width = w, .height = h, .input_size = size}, \
+    .configure = configure_visualizer,                                       \
+    .run.f64 = visualizer,                                                   \
+    .run_ram.f64 = RAM_COPY(visualizer),                                     \
+    .configure_ram = RAM_COPY(configure_visualizer),                         \
+    .repeat = BENCH_REPEAT_AUTO,                                             \
+  }
+
+#define PWM_BENCH(id, size, th, air, area, distance)                         \
+  {                                                                          \
+    .name = "Pwm fan speed controller",                                      \
+    .short_name = "pwm",                                                     \
+    .config = id,                                                            \
+    .input_type = BENCH_INPUT_DOUBLE,                                        \
+    .input_len = size,                                                       \
+    .generate = bench_gen_double,                                            \
+    .scale = 5,                                                              \
+    .params = &(const pwm_config_t){.input_size = size, .temp_th = th,       \
+                                    .airflow = air, .fan_area = area,        \
+                                    .fan_distance = distance},               \
+    .configure = configure_pwm,                                              \
+    .run.f64 = pwm_fan_speed,                                                \
+    .run_ram.f64 = RAM_COPY(pwm_fan_speed),                                  \
+    .configure_ram = RAM_COPY(configure_pwm),                                \
+    .repeat = BENCH_REPEAT_AUTO,                                             \
+  }
+
+// Printable ASCII characters, from ' ' to '~'
+#define HUFFMAN_BENCH(id, size)                                              \
+  {                                                                          \
+    .name = "Huffman compression",                                           \
+    .short_name = "huffman",                                                 \
+    .config = id,                                                            \
+    .input_type = BENCH_INPUT_UINT,                                          \
+    .input_len = size,                                                       \
+    .generate = bench_gen_uint,                                              \
+    .scale = 95,                                                             \
+    .offset = ' ',                                                           \
+    .params = &(const huffman_config_t){.input_size = size},                 \
+    .configure = configure_huffman,                                          \
+    .run.u32 = huffman_compression,                                          \
+    .run_ram.u32 = RAM_COPY(huffman_compression),                            \
+    .configure_ram = RAM_COPY(configure_huffman),                            \
+    .repeat = BENCH_REPEAT_AUTO,                                             \
+  }
+
+#define PATHFIND_BENCH(id, h, w)                                             \
+  {                                                                          \
+    .name = "Pathfinder",                                                    \
+    .short_name = "pathfind",                                                \
+    .config = id,                                                            \
+    .input_type = BENCH_INPUT_UINT,                                          \
+    .input_len = PATHFIND_INPUT_SIZE(h, w),                                  \
+    .generate = bench_gen_pathfind,                                          \
+    .params = &(const pathfind_config_t){.height = h, .width = w},           \
+    .configure = configure_pathfind,                                         \
+    .run.u32 = pathfind,                                                     \
+    .run_ram.u32 = RAM_COPY(pathfind),                                       \
+    .configure_ram = RAM_COPY(configure_pathfind),                           \
+    .repeat = BENCH_REPEAT_AUTO,                                             \
+  }
+
+const bench_t bench_registry[] = {
+  // Config id, image width, image height, input size
+  VIS_BENCH(1, 300, 200, 100),
+  VIS_BENCH(2, 500, 100, 300),
+  VIS_BENCH(3, 300, 197, 1000),
+  // Config id, input size, threshold [°C], airflow [m^3/s], fan area [m^2],
+  // fan distance [m]
+  PWM_BENCH(1, 100, 50, 0.07, 0.0113, 0.1),
+  PWM_BENCH(2, 200, 30, 0.1, 0.0113, 0.07),
+  PWM_BENCH(3, 300, 25, 0.15, 0.0113, 0.05),
+  // Config id, input size
+  HUFFMAN_BENCH(1, 100),
+  HUFFMAN_BENCH(2, 1000),
+  HUFFMAN_BENCH(3, 10000),
+  // Config id, map height, map width
+  PATHFIND_BENCH(1, 5, 5),
+  PATHFIND_BENCH(2, 10, 10),
+  PATHFIND_BENCH(3, 20, 20),
+};
+
+const uint32_t bench_registry_len = sizeof(bench_registry) / sizeof(bench_registry[0]);
+
+/**
+ * @brief Derives the seed of the input of an iteration from the base seed
+ *        (murmur3 finalizer of the two).
+ *
+ * @param seed: the base seed of the run
+ * @param index: the index of the iteration in the run
+ * @return uint32_t: the seed for random_set_seed()
+ */
+uint32_t bench_iteration_seed(uint32_t seed, uint32_t index)
+{
+  uint32_t h = seed ^ (index * 0x9E3779B9U);
+  h ^= h >> 16;
+  h *= 0x85EBCA6BU;
+  h ^= h >> 13;
+  h *= 0xC2B2AE35U;
+  h ^= h >> 16;
+  // random_set_seed() adds up to 127 to the seed: keep it from wrapping
+  // below the minimum seeds of lfsr113
+  return h & 0x7FFFFFFF;
+}
+
+/**
+ * @brief Generates a uniform input in the range [0, scale).
+ */
+void bench_gen_double(const bench_t *bench, void *input)
+{
+  double *in = input;
+  random_get_array(in, bench->input_len);
+  for (uint32_t i = 0; i < bench->input_len; ++i)
+  {
+    in[i] *= bench->scale;
+  }
+}
+
+/**
+ * @brief Generates an integer input as follows:
+ *          input[i] = input[i] % scale + offset
+ *        thus allowing for arbitrary integer values.
+ */
+void bench_gen_uint(const bench_t *bench, void *input)
+{
+  uint32_t *in = input;
+  random_get_iarray(in, bench->input_len);
+  for (uint32_t i = 0; i < bench->input_len; ++i)
+  {
+    in[i] = in[i] % bench->scale + bench->offset;
+  }
+}
+
+/**
+ * @brief Generates the input of the pathfinder: the first 4 values are the
+ *        start and goal coordinates (x, y, x, y, inside the map of the
+ *        entry's params), the remaining ones are the map (0 free cell, 1
+ *        obstacle).
+ */
+void bench_gen_pathfind(const bench_t *bench, void *input)
+{
+  const pathfind_config_t *config = bench->params;
+  uint32_t *in = input;
+  random_get_iarray(in, bench->input_len);
+  for (uint32_t i = 0; i < 4; i += 2)
+  {
+    in[i] = in[i] % config->width;
+    in[i + 1] = in[i + 1] % config->height;
+  }
+  for (uint32_t i = 4; i < bench->input_len; ++i)
+  {
+    in[i] = in[i] % 2;
+  }
+}
@@ -0,0 +1,295 @@
+/**
+ * @file bench_shell.c
+ * @brief Command interpreter driving the benchmark driver from the UART.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "bench.h"
+#include "bench_output.h"
+#include "bench_shell.h"
+#include "uart_rx.h"
+
+#define MAX_ARGS 4
+
+typedef struct
+{
+  const char *name;
+  const char *usage;
+  int argc; // Number of arguments, command name excluded
+  int (*exec)(char *argv[]);
+} command_t;
+
+static char line[BENCH_SHELL_LINE_LEN + 1];
+static uint32_t line_len;
+// Set when the current line is longer than BENCH_SHELL_LINE_LEN
+static uint8_t overflow;
+
+// Registry entry run by 'run'
+static uint32_t selected;
+static uint32_t iters;
+
+static int cmd_help(char *argv[]);
+
+/**
+ * @brief Parses a decimal number.
+ *
+ * @param str: the text to parse
+ * @param value: where the number is stored
+ * @return int: 0 on success, -1 if str is not a number
+ */
+static int parse_u32(const char *str, uint32_t *value)
+{
+  char *end;
+  if (*str < '0' || *str > '9')
+  {
+    return -1;
+  }
+  unsigned long v = strtoul(str, &end, 10);
+  if (*end != '\0' || v > UINT32_MAX)
+  {
+    return -1;
+  }
+  *value = v;
+  return 0;
+}
+
+static int cmd_list(char *argv[])
+{
+  (void)argv;
+  for (uint32_t i = 0; i < bench_registry_len; ++i)
+  {
+    const bench_t *bench = &bench_registry[i];
+    printf("%lu: %s config %lu, %lu inputs\r\n", (long unsigned int)i, bench->name,
+           (long unsigned int)bench->config, (long unsigned int)bench->input_len);
+  }
+  return 0;
+}
+
+static int cmd_select(char *argv[])
+{
+  uint32_t index;
+  if (parse_u32(argv[0], &index) != 0 || index >= bench_registry_len)
+  {
+    printf("ERR no entry %s\r\n", argv[0]);
+    return -1;
+  }
+  selected = index;
+  return 0;
+}
+
+static int cmd_config(char *argv[])
+{
+  uint32_t config;
+  if (parse_u32(argv[0], &config) == 0)
+  {
+    const char *name = bench_registry[selected].name;
+    for (uint32_t i = 0; i < bench_registry_len; ++i)
+    {
+      if (bench_registry[i].config == config && strcmp(bench_registry[i].name, name) == 0)
+      {
+        selected = i;
+        return 0;
+      }
+    }
+  }
+  printf("ERR no config %s\r\n", argv[0]);
+  return -1;
+}
+
+static int cmd_iters(char *argv[])
+{
+  uint32_t value;
+  if (parse_u32(argv[0], &value) != 0 || value == 0)
+  {
+    printf("ERR invalid count %s\r\n", argv[0]);
+    return -1;
+  }
+  iters = value;
+  return 0;
+}
+
+static int cmd_seed(char *argv[])
+{
+  if (parse_u32(argv[0], &bench_options.seed) != 0)
+  {
+    printf("ERR invalid seed %s\r\n", argv[0]);
+    return -1;
+  }
+  return 0;
+}
+
+static int cmd_warmup(char *argv[])
+{
+  if (parse_u32(argv[0], &bench_options.warmup) != 0)
+  {
+    printf("ERR invalid count %s\r\n", argv[0]);
+    return -1;
+  }
+  return 0;
+}
+
+static int cmd_output(char *argv[])
+{
+  if (strcmp(argv[0], "text") == 0)
+  {
+    bench_options.output = BENCH_OUTPUT_TEXT;
+  }
+  else if (strcmp(argv[0], "binary") == 0)
+  {
+    bench_options.output = BENCH_OUTPUT_BINARY;
+  }
+  else
+  {
+    printf("ERR unknown output %s\r\n", argv[0]);
+    return -1;
+  }
+  return 0;
+}
+
+static int cmd_show(char *argv[])
+{
+  (void)argv;
+  const bench_t *bench = &bench_registry[selected];
+  printf("Selected: %lu: %s config %lu\r\n", (long unsigned int)selected, bench->name,
+         (long unsigned int)bench->config);
+  printf("Iterations: %lu, seed: %lu, warmup: %lu, output: %s\r\n", (long unsigned int)iters,
+         (long unsigned int)bench_options.seed, (long unsigned int)bench_options.warmup,
+         bench_options.output == BENCH_OUTPUT_BINARY ? "binary" : "text");
+  return 0;
+}
+
+static int cmd_run(char *argv[])
+{
+  (void)argv;
+  if (bench_run(&bench_registry[selected], iters, NULL) != 0)
+  {
+    printf("ERR run failed\r\n");
+    return -1;
+  }
+  return 0;
+}
+
+static int cmd_all(char *argv[])
+{
+  (void)argv;
+  bench_run_all(iters);
+  return 0;
+}
+
+static const command_t commands[] = {
+  {"help", "help", 0, cmd_help},
+  {"list", "list", 0, cmd_list},
+  {"select", "select <index>", 1, cmd_select},
+  {"config", "config <id>", 1, cmd_config},
+  {"iters", "iters <n>", 1, cmd_iters},
+  {"seed", "seed <n>", 1, cmd_seed},
+  {"warmup", "warmup <n>", 1, cmd_warmup},
+  {"output", "output text|binary", 1, cmd_output},
+  {"show", "show", 0, cmd_show},
+  {"run", "run", 0, cmd_run},
+  {"all", "all", 0, cmd_all},
+  {NULL, NULL, 0, NULL},
+};
+
+static int cmd_help(char *argv[])
+{
+  (void)argv;
+  for (const command_t *cmd = commands; cmd->name != NULL; ++cmd)
+  {
+    printf("%s\r\n", cmd->usage);
+  }
+  return 0;
+}
+
+/**
+ * @brief Splits a line into words and runs the command, then sends the
+ *        "OK" line if it succeeded (failed commands send their "ERR" line).
+ */
+static void execute(char *text)
+{
+  char *argv[MAX_ARGS + 1];
+  int argc = 0;
+  for (char *word = strtok(text, " \t"); word != NULL; word = strtok(NULL, " \t"))
+  {
+    if (argc == MAX_ARGS + 1)
+    {
+      printf("ERR too many arguments\r\n");
+      return;
+    }
+    argv[argc++] = word;
+  }
+  if (argc == 0)
+  {
+    return;
+  }
+  for (const command_t *cmd = commands; cmd->name != NULL; ++cmd)
+  {
+    if (strcmp(argv[0], cmd->name) != 0)
+    {
+      continue;
+    }
+    if (argc - 1 != cmd->argc)
+    {
+      printf("ERR usage: %s\r\n", cmd->usage);
+    }
+    else if (cmd->exec(&argv[1]) == 0)
+    {
+      printf("OK\r\n");
+    }
+    return;
+  }
+  printf("ERR unknown command %s\r\n", argv[0]);
+}
+
+/**
+ * @brief Starts the reception of the commands.
+ *
+ * @param iter: the initial iteration count of the runs
+ */
+void bench_shell_init(uint32_t iter)
+{
+  iters = iter;
+  selected = 0;
+  line_len = 0;
+  overflow = 0;
+  uart_rx_start();
+  printf("Ready, %lu benchmarks\r\n", (long unsigned int)bench_registry_len);
+  fflush(stdout);
+}
+
+/**
+ * @brief Runs the commands received since the last call. Does not wait for
+ *        new input.
+ */
+void bench_shell_poll(void)
+{
+  int ch;
+  while ((ch = uart_rx_getchar()) >= 0)
+  {
+    if (ch == '\r' || ch == '\n')
+    {
+      if (overflow)
+      {
+        printf("ERR line too long\r\n");
+      }
+      else
+      {
+        line[line_len] = '\0';
+        execute(line);
+      }
+      line_len = 0;
+      overflow = 0;
+      fflush(stdout);
+    }
+    else if (line_len < BENCH_SHELL_LINE_LEN)
+    {
+      line[line_len++] = ch;
+    }
+    else
+    {
+      overflow = 1;
+    }
+  }
+}
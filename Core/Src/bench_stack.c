@@ -0,0 +1,58 @@
+/**
+ * @file bench_stack.c
+ * @brief Stack high-water mark measurement by stack painting.
+ */
+
+#include "main.h"
+#include "bench_stack.h"
+
+// Words left unpainted below the stack pointer of bench_stack_paint()
+#define PAINT_MARGIN 8
+
+// Painted region: [paint_bottom, paint_top)
+static uint32_t *paint_bottom;
+static uint32_t *paint_top;
+
+/**
+ * @brief Fills the free stack with BENCH_STACK_PATTERN.
+ *
+ * @param bottom: the lowest address the stack may reach, i.e. the end of the
+ *        input in the arena (see bench.h)
+ */
+void bench_stack_paint(const void *bottom)
+{
+  paint_bottom = (uint32_t *)(((uintptr_t)bottom + 3) & ~(uintptr_t)3);
+  paint_top = (uint32_t *)__get_MSP() - PAINT_MARGIN;
+  for (volatile uint32_t *p = paint_bottom; p < paint_top; ++p)
+  {
+    *p = BENCH_STACK_PATTERN;
+  }
+}
+
+/**
+ * @brief Finds how deep the stack grew since the last bench_stack_paint().
+ *
+ * @return uint32_t: the number of bytes used below the painted region's top
+ *         (just below the stack pointer of bench_stack_paint()); all of the
+ *         region if the stack reached the input
+ */
+uint32_t bench_stack_used(void)
+{
+  const volatile uint32_t *p = paint_bottom;
+  while (p < paint_top && *p == BENCH_STACK_PATTERN)
+  {
+    ++p;
+  }
+  return (paint_top - p) * sizeof(uint32_t);
+}
+
+/**
+ * @brief Tells whether the stack reached the bottom of the painted region
+ *        since the last bench_stack_paint().
+ *
+ * @return int: 1 if the lowest painted word was overwritten, 0 otherwise
+ */
+int bench_stack_overrun(void)
+{
+  return paint_bottom < paint_top && *(volatile uint32_t *)paint_bottom != BENCH_STACK_PATTERN;
+}
@@ -0,0 +1,244 @@
+/**
+ * @file bench_stats.c
+ * @brief Streaming statistics: Welford mean and variance, P^2 quantiles,
+ * sliding window coefficient of variation.
+ */
+
+#include <math.h>
+#include "bench_stats.h"
+
+void bench_stats_init(bench_stats_t *stats)
+{
+  stats->count = 0;
+  stats->min = UINT64_MAX;
+  stats->max = 0;
+  stats->mean = 0;
+  stats->m2 = 0;
+  bench_p2_init(&stats->p50, 0.5);
+  bench_p2_init(&stats->p90, 0.9);
+  bench_p2_init(&stats->p99, 0.99);
+}
+
+/**
+ * @brief Adds a sample to the statistics.
+ *
+ * @param stats: the statistics
+ * @param sample: the new sample
+ */
+void bench_stats_add(bench_stats_t *stats, uint64_t sample)
+{
+  double x = sample;
+  ++stats->count;
+  if (sample < stats->min)
+  {
+    stats->min = sample;
+  }
+  if (sample > stats->max)
+  {
+    stats->max = sample;
+  }
+  double delta = x - stats->mean;
+  stats->mean += delta / stats->count;
+  stats->m2 += delta * (x - stats->mean);
+  bench_p2_add(&stats->p50, x);
+  bench_p2_add(&stats->p90, x);
+  bench_p2_add(&stats->p99, x);
+}
+
+/**
+ * @brief Sample standard deviation (0 with less than two samples).
+ */
+double bench_stats_stddev(const bench_stats_t *stats)
+{
+  if (stats->count < 2)
+  {
+    return 0;
+  }
+  return sqrt(stats->m2 / (stats->count - 1));
+}
+
+void bench_window_init(bench_window_t *window)
+{
+  window->count = 0;
+}
+
+/**
+ * @brief Adds a sample to the window, replacing the oldest one when full.
+ */
+void bench_window_add(bench_window_t *window, uint64_t sample)
+{
+  window->samples[window->count % BENCH_WINDOW_LEN] = sample;
+  ++window->count;
+}
+
+/**
+ * @brief Coefficient of variation (sample standard deviation over mean) of
+ *        the samples in the window.
+ *
+ * @return double: the coefficient, or INFINITY until the window is full
+ */
+double bench_window_cv(const bench_window_t *window)
+{
+  if (window->count < BENCH_WINDOW_LEN)
+  {
+    return INFINITY;
+  }
+  double mean = 0, m2 = 0;
+  for (uint32_t i = 0; i < BENCH_WINDOW_LEN; ++i)
+  {
+    mean += window->samples[i];
+  }
+  mean /= BENCH_WINDOW_LEN;
+  if (mean == 0)
+  {
+    return 0;
+  }
+  for (uint32_t i = 0; i < BENCH_WINDOW_LEN; ++i)
+  {
+    double d = window->samples[i] - mean;
+    m2 += d * d;
+  }
+  return sqrt(m2 / (BENCH_WINDOW_LEN - 1)) / mean;
+}
+
+void bench_p2_init(bench_p2_t *p2, double p)
+{
+  p2->p = p;
+  p2->count = 0;
+  p2->dn[0] = 0;
+  p2->dn[1] = p / 2;
+  p2->dn[2] = p;
+  p2->dn[3] = (1 + p) / 2;
+  p2->dn[4] = 1;
+}
+
+static void sort5(double *a, uint32_t len)
+{
+  for (uint32_t i = 1; i < len; ++i)
+  {
+    double v = a[i];
+    uint32_t j = i;
+    for (; j > 0 && a[j - 1] > v; --j)
+    {
+      a[j] = a[j - 1];
+    }
+    a[j] = v;
+  }
+}
+
+/**
+ * @brief Piecewise-parabolic prediction of the height of marker i, moved by
+ *        d (+1 or -1) positions.
+ */
+static double parabolic(const bench_p2_t *p2, int i, double d)
+{
+  const double *q = p2->q, *n = p2->n;
+  return q[i] + d / (n[i + 1] - n[i - 1]) *
+                    ((n[i] - n[i - 1] + d) * (q[i + 1] - q[i]) / (n[i + 1] - n[i]) +
+                     (n[i + 1] - n[i] - d) * (q[i] - q[i - 1]) / (n[i] - n[i - 1]));
+}
+
+/**
+ * @brief Linear prediction of the height of marker i, moved by d positions.
+ */
+static double linear(const bench_p2_t *p2, int i, int d)
+{
+  return p2->q[i] + d * (p2->q[i + d] - p2->q[i]) / (p2->n[i + d] - p2->n[i]);
+}
+
+/**
+ * @brief Adds an observation to the estimator.
+ *
+ * @param p2: the estimator
+ * @param x: the observation
+ */
+void bench_p2_add(bench_p2_t *p2, double x)
+{
+  if (p2->count < 5)
+  {
+    p2->q[p2->count++] = x;
+    if (p2->count == 5)
+    {
+      sort5(p2->q, 5);
+      for (int i = 0; i < 5; ++i)
+      {
+        p2->n[i] = i + 1;
+      }
+      p2->np[0] = 1;
+      p2->np[1] = 1 + 2 * p2->p;
+      p2->np[2] = 1 + 4 * p2->p;
+      p2->np[3] = 3 + 2 * p2->p;
+      p2->np[4] = 5;
+    }
+    return;
+  }
+  // Find the cell k such that q[k] <= x < q[k + 1], extending the extremes
+  int k;
+  if (x < p2->q[0])
+  {
+    p2->q[0] = x;
+    k = 0;
+  }
+  else if (x >= p2->q[4])
+  {
+    p2->q[4] = x;
+    k = 3;
+  }
+  else
+  {
+    for (k = 0; k < 3 && x >= p2->q[k + 1]; ++k)
+    {
+    }
+  }
+  for (int i = k + 1; i < 5; ++i)
+  {
+    p2->n[i] += 1;
+  }
+  for (int i = 0; i < 5; ++i)
+  {
+    p2->np[i] += p2->dn[i];
+  }
+  ++p2->count;
+  // Adjust the heights of the middle markers
+  for (int i = 1; i < 4; ++i)
+  {
+    double d = p2->np[i] - p2->n[i];
+    if ((d >= 1 && p2->n[i + 1] - p2->n[i] > 1) || (d <= -1 && p2->n[i - 1] - p2->n[i] < -1))
+    {
+      int s = d >= 0 ? 1 : -1;
+      double q = parabolic(p2, i, s);
+      if (p2->q[i - 1] < q && q < p2->q[i + 1])
+      {
+        p2->q[i] = q;
+      }
+      else
+      {
+        p2->q[i] = linear(p2, i, s);
+      }
+      p2->n[i] += s;
+    }
+  }
+}
+
+/**
+ * @brief Current estimate of the quantile (exact with less than five
+ *        observations, 0 with none).
+ */
+double bench_p2_get(const bench_p2_t *p2)
+{
+  if (p2->count >= 5)
+  {
+    return p2->q[2];
+  }
+  if (p2->count == 0)
+  {
+    return 0;
+  }
+  double sorted[5];
+  for (uint32_t i = 0; i < p2->count; ++i)
+  {
+    sorted[i] = p2->q[i];
+  }
+  sort5(sorted, p2->count);
+  return sorted[(uint32_t)(p2->p * (p2->count - 1) + 0.5)];
+}
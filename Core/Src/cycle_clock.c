@@ -0,0 +1,63 @@
+/**
+ * @file cycle_clock.c
+ * @brief 64-bit extension of the DWT cycle counter.
+ */
+
+#include "main.h"
+#include "cycle_clock.h"
+
+// HAL ticks between two reads of the clock by cycle_clock_update(); the
+// CYCCNT period must be longer than that at any system clock frequency
+#ifndef CYCLE_CLOCK_UPDATE_TICKS
+#define CYCLE_CLOCK_UPDATE_TICKS 1000
+#endif
+
+static uint32_t wraps;     // Upper 32 bits of the clock
+static uint32_t last_read; // Last CYCCNT value observed
+static uint32_t ticks;     // HAL ticks since the last update
+
+/**
+ * @brief Enables the DWT cycle counter and resets the clock.
+ */
+void cycle_clock_init(void)
+{
+  CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+  DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+  DWT->CYCCNT = 0;
+  wraps = 0;
+  last_read = 0;
+  ticks = 0;
+}
+
+/**
+ * @brief Reads the clock. Can be called from both thread and interrupt mode.
+ *
+ * @return uint64_t: the cycles elapsed since cycle_clock_init()
+ */
+uint64_t cycle_clock_now(void)
+{
+  uint32_t primask = __get_PRIMASK();
+  __disable_irq();
+  uint32_t now = DWT->CYCCNT;
+  if (now < last_read)
+  {
+    ++wraps;
+  }
+  last_read = now;
+  uint64_t cycles = ((uint64_t)wraps << 32) | now;
+  __set_PRIMASK(primask);
+  return cycles;
+}
+
+/**
+ * @brief Keeps track of the wraps of CYCCNT. Called at every HAL tick, it
+ *        reads the clock every CYCLE_CLOCK_UPDATE_TICKS ticks.
+ */
+void cycle_clock_update(void)
+{
+  if (++ticks >= CYCLE_CLOCK_UPDATE_TICKS)
+  {
+    ticks = 0;
+    (void)cycle_clock_now();
+  }
+}
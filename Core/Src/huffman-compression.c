@@ -5,7 +5,8 @@
  */
 
 #include "huffman-compression.h"
-#include <math.h>
+#include "kernel_placement.h"
+#include <stddef.h>
 
 #define INT_BIT_SIZE sizeof(int) * 8
 
@@ -27,6 +28,10 @@
 // Adapt if the architecture's int size is not 4 bytes
 #define SYMBOL_BYTE_LEN 3 // (ceil(CHAR_DOMAIN_LEN / INT_BIT_SIZE));
 
+// Words of the code of the longest input. The size of the code is not bigger
+// than the size of the input.
+#define CODE_SPACE ((HUFFMAN_MAX_INPUT_SIZE + sizeof(int) - 1) / sizeof(int))
+
 /**
  * @brief Node to be used for both heap and tree.
  */
@@ -44,58 +49,102 @@ typedef struct {
     int inserted_at;
 } Node;
 
-unsigned int compute_input_statistics(unsigned int input[HUFFMAN_INPUT_SIZE],
-                                      unsigned int freq[CHAR_DOMAIN_LEN]);
+// Length of the input (config 1 by default)
+static unsigned int input_size = 100;
+
+#if KERNEL_OUTPUT_HOOKS
+// Receiver of the codes (none by default)
+static huffman_output_t output_fn;
+#endif
+
+static unsigned int compute_input_statistics(unsigned int input[],
+                                             unsigned int freq[CHAR_DOMAIN_LEN]);
 
 // Heap
 
 // Initialize the heap
-void init_heap(unsigned int size, Node heap[size],
-               unsigned int freq[CHAR_DOMAIN_LEN]);
+static void init_heap(unsigned int size, Node heap[size],
+                      unsigned int freq[CHAR_DOMAIN_LEN]);
 // Insert a node in the heap
-void insert_in_heap(unsigned int *size, Node *heap, Node node);
+static void insert_in_heap(unsigned int *size, Node *heap, Node node);
 // Pop a node out of the heap
-Node pop(unsigned int *size, Node *heap);
+static Node pop(unsigned int *size, Node *heap);
 
 // Tree
 
-void init_huffman_tree(Node *heap, unsigned int *heap_size, Node *tree,
-                       unsigned int *tree_size);
+static void init_huffman_tree(Node *heap, unsigned int *heap_size, Node *tree,
+                              unsigned int *tree_size);
 // Merge the symbol of two nodes, given their position in the tree, and return
 // the merged node
-Node merge_nodes(Node *tree, unsigned int node_a, unsigned int node_b);
+static Node merge_nodes(Node *tree, unsigned int node_a, unsigned int node_b);
 // Insert a node in the tree, at the end of the tree
-void insert_in_tree(unsigned int *size, Node *tree, Node *node);
-unsigned int encode_input(unsigned int input[HUFFMAN_INPUT_SIZE], Node *tree,
-                          unsigned int tree_size, unsigned int *code);
-void decode_code(unsigned int *code, unsigned int code_len, Node *tree,
-                 unsigned int tree_size, char output[HUFFMAN_INPUT_SIZE + 1]);
-
-void huffman_compression(unsigned int input[HUFFMAN_INPUT_SIZE]) {
-    // Compress the input
+static void insert_in_tree(unsigned int *size, Node *tree, Node *node);
+static unsigned int encode_input(unsigned int input[], Node *tree,
+                                 unsigned int tree_size, unsigned int *code);
+static void decode_code(unsigned int *code, unsigned int code_len, Node *tree,
+                        unsigned int tree_size, char output[]);
+
+/**
+ * @brief Sets the length of the input of the next calls.
+ *
+ * @param config: the new configuration
+ * @return int: 0 on success, -1 if the length exceeds the maximum
+ */
+int huffman_configure(const huffman_config_t *config) {
+    if (config->input_size < 1 || config->input_size > HUFFMAN_MAX_INPUT_SIZE) {
+        return -1;
+    }
+    input_size = config->input_size;
+    return 0;
+}
+
+/**
+ * @brief Sets the function that receives the code of the next calls.
+ *
+ * @param output: the receiver, or NULL
+ */
+#if KERNEL_OUTPUT_HOOKS
+void huffman_set_output(huffman_output_t output) {
+    output_fn = output;
+}
+#endif
+
+KERNEL_RAMFUNC unsigned int huffman_compression(unsigned int input[]) {
+    // Compress the input. The buffers are sized for the whole character
+    // domain and the longest input, so that the stack used does not depend
+    // on the configuration.
     // Evaluate character statistics
     unsigned int freq[CHAR_DOMAIN_LEN] = {0};
     // Total amount of unique characters
     unsigned int total = compute_input_statistics(input, freq);
-    Node priority_queue[total];
+    Node priority_queue[CHAR_DOMAIN_LEN];
     init_heap(total, priority_queue, freq);
     unsigned int heap_size = total;
     // Make the tree
     unsigned int tree_size = 0;
-    Node tree[2 * total - 1];
+    Node tree[2 * CHAR_DOMAIN_LEN - 1];
     init_huffman_tree(priority_queue, &heap_size, tree, &tree_size);
     // Encode the input
-    unsigned int huffman_code_space =
-        ceilf((float)HUFFMAN_INPUT_SIZE /
-              sizeof(int)); // The size of the code is not bigger
-                            // than the size of the input.
-    unsigned int code[huffman_code_space];
+    unsigned int code[CODE_SPACE];
     unsigned int code_len = encode_input(input, tree, tree_size, code);
 
     // Ensure that the decoded string matches with the original one
-    char decoded[HUFFMAN_INPUT_SIZE + 1];
-    decoded[HUFFMAN_INPUT_SIZE] = '\0';
+    char decoded[HUFFMAN_MAX_INPUT_SIZE + 1];
+    decoded[input_size] = '\0';
     decode_code(code, code_len, tree, tree_size, decoded);
+#if KERNEL_OUTPUT_HOOKS
+    if (output_fn != NULL) {
+        output_fn(code, code_len, decoded);
+    }
+#endif
+
+    // Checksum of the decoded string, so that the decoding is not optimized
+    // away. It is the same as the checksum of the input if the coding works.
+    unsigned int checksum = 0;
+    for (unsigned int i = 0; i < input_size; ++i) {
+        checksum = checksum * 31 + decoded[i];
+    }
+    return checksum;
 }
 
 /**
@@ -106,11 +155,11 @@ void huffman_compression(unsigned int input[HUFFMAN_INPUT_SIZE]) {
  * @param freq: the array to use as histogram
  * @return int: the amount of unique characters
  */
-unsigned int compute_input_statistics(unsigned int input[HUFFMAN_INPUT_SIZE],
-                                      unsigned int freq[CHAR_DOMAIN_LEN]) {
+static KERNEL_RAMFUNC unsigned int compute_input_statistics(unsigned int input[],
+                                                            unsigned int freq[CHAR_DOMAIN_LEN]) {
     int total = 0;
     int next_char;
-    for (unsigned int i = 0; i < HUFFMAN_INPUT_SIZE; ++i) {
+    for (unsigned int i = 0; i < input_size; ++i) {
         next_char = input[i] - ' ';
         if (freq[next_char] == 0) {
             total++;
@@ -127,7 +176,7 @@ unsigned int compute_input_statistics(unsigned int input[HUFFMAN_INPUT_SIZE],
  * @param pos the position of the child
  * @return int: the position of the parent
  */
-unsigned int parent(unsigned int pos) { return (pos - 1) / 2; }
+static KERNEL_RAMFUNC unsigned int parent(unsigned int pos) { return (pos - 1) / 2; }
 
 /**
  * @brief Left child of the node. No check against its actual existence is
@@ -136,7 +185,7 @@ unsigned int parent(unsigned int pos) { return (pos - 1) / 2; }
  * @param pos the position of the parent
  * @return int: the position of the left child
  */
-unsigned int left(int pos) { return 2 * pos + 1; }
+static KERNEL_RAMFUNC unsigned int left(int pos) { return 2 * pos + 1; }
 
 /**
  * @brief Right child of the node. No check against its actual existence is
@@ -145,15 +194,15 @@ unsigned int left(int pos) { return 2 * pos + 1; }
  * @param pos the position of the parent
  * @return int: the position of the right child
  */
-unsigned int right(int pos) { return 2 * pos + 2; }
+static KERNEL_RAMFUNC unsigned int right(int pos) { return 2 * pos + 2; }
 
-void swap(Node *a, Node *b) {
+static KERNEL_RAMFUNC void swap(Node *a, Node *b) {
     Node t = *a;
     *a = *b;
     *b = t;
 }
 
-void heapify(unsigned int size, Node heap[size]) {
+static KERNEL_RAMFUNC void heapify(unsigned int size, Node heap[size]) {
     unsigned int start = size >> 1;
     unsigned int root, child;
     while (start > 0) {
@@ -185,8 +234,8 @@ void heapify(unsigned int size, Node heap[size]) {
  * @param heap the heap
  * @param freq the reference histogram
  */
-void init_heap(unsigned int size, Node heap[size],
-               unsigned int freq[CHAR_DOMAIN_LEN]) {
+static KERNEL_RAMFUNC void init_heap(unsigned int size, Node heap[size],
+                                     unsigned int freq[CHAR_DOMAIN_LEN]) {
     unsigned int cur = 0;
     for (unsigned int i = 0; i < CHAR_DOMAIN_LEN && cur < size; ++i) {
         if (freq[i] > 0) {
@@ -212,7 +261,7 @@ void init_heap(unsigned int size, Node heap[size],
     // if cur != size, there should be an error somewhere
 }
 
-void insert_in_heap(unsigned int *size, Node *heap, Node node) {
+static KERNEL_RAMFUNC void insert_in_heap(unsigned int *size, Node *heap, Node node) {
     // Inserts occurr always after two pops, so out-of-bound checks should
     // never be necessary.
     heap[*size] = node;
@@ -224,7 +273,7 @@ void insert_in_heap(unsigned int *size, Node *heap, Node node) {
     ++(*size);
 }
 
-Node pop(unsigned int *size, Node *heap) {
+static KERNEL_RAMFUNC Node pop(unsigned int *size, Node *heap) {
     Node to_extract = heap[0];
     --(*size);
     heap[0] = heap[*size];
@@ -247,8 +296,8 @@ Node pop(unsigned int *size, Node *heap) {
 
 // TREE
 
-void init_huffman_tree(Node *heap, unsigned int *heap_size, Node *tree,
-                       unsigned int *tree_size) {
+static KERNEL_RAMFUNC void init_huffman_tree(Node *heap, unsigned int *heap_size, Node *tree,
+                                             unsigned int *tree_size) {
     while (*heap_size > 1) {
         Node a = pop(heap_size, heap);
         if (a.inserted_at == -1) {
@@ -264,7 +313,7 @@ void init_huffman_tree(Node *heap, unsigned int *heap_size, Node *tree,
     }
 }
 
-Node merge_nodes(Node *tree, unsigned int node_a, unsigned int node_b) {
+static KERNEL_RAMFUNC Node merge_nodes(Node *tree, unsigned int node_a, unsigned int node_b) {
     Node a = tree[node_a];
     Node b = tree[node_b];
     Node merge = {.left = node_a,
@@ -277,7 +326,7 @@ Node merge_nodes(Node *tree, unsigned int node_a, unsigned int node_b) {
     return merge;
 }
 
-void insert_in_tree(unsigned int *size, Node *tree, Node *node) {
+static KERNEL_RAMFUNC void insert_in_tree(unsigned int *size, Node *tree, Node *node) {
     if (node->inserted_at != -1) {
         // Already inserted
         return;
@@ -287,7 +336,7 @@ void insert_in_tree(unsigned int *size, Node *tree, Node *node) {
     ++(*size);
 }
 
-unsigned int encode(unsigned int size, Node *tree, char ch, unsigned int *len) {
+static KERNEL_RAMFUNC unsigned int encode(unsigned int size, Node *tree, char ch, unsigned int *len) {
     unsigned int ch_byte = CHAR_MAP_INDEX(ch);
     unsigned int ch_bit = CHAR_BIT_INDEX(ch);
     unsigned int code = 0;
@@ -305,15 +354,15 @@ unsigned int encode(unsigned int size, Node *tree, char ch, unsigned int *len) {
     return code;
 }
 
-unsigned int encode_input(unsigned int input[HUFFMAN_INPUT_SIZE], Node *tree,
-                          unsigned int tree_size, unsigned int *code) {
+static KERNEL_RAMFUNC unsigned int encode_input(unsigned int input[], Node *tree,
+                                                unsigned int tree_size, unsigned int *code) {
     unsigned int code_len = 0;
     unsigned int curr_cell = 0, curr_cell_bit = 0;
     // Used to store single encoded characters
     unsigned int piece, piece_len = 0;
     // If information is fragmented, use these
     unsigned int first_fragment_len;
-    for (unsigned int i = 0; i < HUFFMAN_INPUT_SIZE; ++i) {
+    for (unsigned int i = 0; i < input_size; ++i) {
         piece = encode(tree_size, tree, input[i], &piece_len);
         // If the next chunk overlaps between two cells, cut it in two
         if (curr_cell_bit + piece_len > INT_BIT_SIZE) {
@@ -340,8 +389,8 @@ unsigned int encode_input(unsigned int input[HUFFMAN_INPUT_SIZE], Node *tree,
     return code_len;
 }
 
-char decode(unsigned int size, Node *tree, unsigned int input,
-            unsigned int *len) {
+static KERNEL_RAMFUNC char decode(unsigned int size, Node *tree, unsigned int input,
+                                  unsigned int *len) {
     // Input goes from MSB to LSB
     Node node = tree[size - 1];
     unsigned int index;
@@ -371,8 +420,8 @@ char decode(unsigned int size, Node *tree, unsigned int input,
     return ch;
 }
 
-void decode_code(unsigned int *code, unsigned int code_len, Node *tree,
-                 unsigned int tree_size, char output[HUFFMAN_INPUT_SIZE + 1]) {
+static KERNEL_RAMFUNC void decode_code(unsigned int *code, unsigned int code_len, Node *tree,
+                                       unsigned int tree_size, char output[]) {
     unsigned int next_ch_index = 0;
     unsigned int to_decode = code_len;
     unsigned int first_fragment_len;
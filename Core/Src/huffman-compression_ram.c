@@ -0,0 +1,15 @@
+/**
+ * @file huffman-compression_ram.c
+ * @brief Copy of the kernel of huffman-compression.c placed in RAM, built with
+ * BENCH_RAM_KERNELS (see kernel_placement.h).
+ */
+
+#include "bench.h"
+
+#if BENCH_RAM_KERNELS
+#define KERNEL_RAMFUNC_SECTION ".RamFunc.huffman_compression"
+#define huffman_compression huffman_compression_ram
+#define huffman_configure huffman_configure_ram
+#define huffman_set_output huffman_set_output_ram
+#include "huffman-compression.c"
+#endif
@@ -18,17 +18,19 @@
 /* USER CODE END Header */
 /* Includes ------------------------------------------------------------------*/
 #include "main.h"
+#include "dma.h"
 #include "usart.h"
 #include "gpio.h"
 
 /* Private includes ----------------------------------------------------------*/
 /* USER CODE BEGIN Includes */
 #include <stdio.h>
-#include "visualizer.h"
-#include "pwm-fan-speed.h"
-#include "huffman-compression.h"
-#include "simple_random.h"
-#include "pathfind.h"
+#include "bench.h"
+#include "bench_clock.h"
+#include "bench_flash.h"
+#include "bench_ram.h"
+#include "bench_shell.h"
+#include "uart_tx.h"
 /* USER CODE END Includes */
 
 /* Private typedef -----------------------------------------------------------*/
@@ -57,9 +59,6 @@ void SystemClock_Config(void);
 
 /* USER CODE BEGIN PFP */
 
-void bench(void (*benchmark)(double *), uint32_t input_len, uint32_t iter, uint32_t rescale);
-void bench_int(void (*benchmark)(unsigned int *), uint32_t input_len, uint32_t iter, uint32_t rescale_mod, int32_t rescale_offset);
-void bench_int_pathfind(void (*benchmark)(unsigned int *), uint32_t input_len, uint32_t iter, uint32_t rescale_mod);
 /* USER CODE END PFP */
 
 /* Private user code ---------------------------------------------------------*/
@@ -96,35 +95,34 @@ int main(void)
 
   /* Initialize all configured peripherals */
   MX_GPIO_Init();
+  MX_DMA_Init();
   MX_USART2_UART_Init();
   /* USER CODE BEGIN 2 */
 
-  // Enable the counter
-  DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
-  CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
-  // Set random seed
-  random_set_seed(42);
+  // Enable the counters
+  bench_init();
+  // The inputs are seeded per iteration from bench_options.seed
   uint32_t iters = 1000;
 
-  // Visualizer
-  printf("Start bench Visualizer\r\n");
-  bench(visualizer, VIS_INPUT_SIZE, iters, VIS_INPUT_SCALE);
-  printf("Done bench Visualizer\r\n");
-
-  // Pwm-fan-speed
-  printf("Start bench Pwm fan speed controller\r\n");
-  bench(pwm_fan_speed, PWM_INPUT_SIZE, iters, PWM_INPUT_SCALE);
-  printf("Done bench Pwm fan speed controller\r\n");
-
-  // Huffman compression
-  printf("Start bench Huffman compression\r\n");
-  bench_int(huffman_compression, HUFFMAN_INPUT_SIZE, iters, 95,  32);
-  printf("Done bench Huffman compression\r\n");
-
-  // Pathfind
-  printf("Start bench Pathfinder\r\n");
-  bench_int_pathfind(pathfind, PATHFIND_INPUT_SIZE, iters, PATHFIND_HEIGHT);
-  printf("Done bench Pathfinder\r\n");
+#if BENCH_REPLAY
+  // Time again a single iteration of a benchmark
+  bench_replay(&bench_registry[BENCH_REPLAY_ENTRY], BENCH_REPLAY_INDEX, iters);
+#elif BENCH_CLOCK_SWEEP
+  // Run the suite under every clock configuration
+  bench_clock_sweep(iters);
+#elif BENCH_FLASH_SWEEP
+  // Run every benchmark under each flash accelerator setting
+  bench_flash_sweep(iters);
+#elif BENCH_RAM_KERNELS
+  // Compare the kernels run from flash and from RAM
+  bench_ram_compare(iters);
+#elif BENCH_SHELL
+  // Wait for commands on the UART, polled by the main loop
+  bench_shell_init(iters);
+#else
+  // Run every benchmark of the registry
+  bench_run_all(iters);
+#endif
 
   /* USER CODE END 2 */
 
@@ -135,6 +133,9 @@ int main(void)
     /* USER CODE END WHILE */
 
     /* USER CODE BEGIN 3 */
+#if BENCH_SHELL
+    bench_shell_poll();
+#endif
   }
   /* USER CODE END 3 */
 }
@@ -184,118 +185,9 @@ void SystemClock_Config(void)
 
 /* USER CODE BEGIN 4 */
 
-/**
- * @brief Runs the given benchmark.
- *
- * @param benchmark: the main benchmark function
- * @param input_len: the length of the input for the benchmark
- * @param iter: the number of iterations: each iteration will have different input
- * @param rescale: a parameter to rescale the input (which is in the range U[0,1)
- */
-void bench(void (*benchmark)(double *), uint32_t input_len,
-             uint32_t iter, uint32_t rescale)
-{
-  double input[input_len];
-  long unsigned int single_iter_lapse;
-  for (int i = 0; i < iter; ++i)
-  {
-    // Randomize array
-    random_get_array(input, input_len);
-    // Optionally, rescale the input
-    for (int i = 0; i < input_len; ++i)
-    {
-      input[i] *= rescale;
-    }
-    // Reset the system counter to avoid overflows
-    DWT->CYCCNT = 0;
-    // Run the bench
-    benchmark(input);
-    single_iter_lapse = DWT->CYCCNT;
-    printf("%lu\r\n", single_iter_lapse);
-  }
-}
-
-/**
- * @brief Runs the given benchmark, with integer inputs.
- *        A rescaling on the input is done as follows:
- *          input[i] = input[i] % rescale_mod + rescale_offset
- *        thus allowing for arbitrary integer values.
- *
- * @param benchmark: the main benchmark function
- * @param input_len: the length of the input for the benchmark
- * @param iter: the number of iterations: each iteration will have different input
- * @param rescale_mod: the range of integer values (from 0 to rescale_mod-1)
- * @param rescale_offset: the range offset (to sum to each input value)
- */
-void bench_int(void (*benchmark)(unsigned int *), uint32_t input_len,
-                 uint32_t iter, uint32_t rescale_mod, int32_t rescale_offset)
-{
-  uint32_t input[input_len];
-  long unsigned int single_iter_lapse;
-  for (int i = 0; i < iter; ++i)
-  {
-    // Randomize array
-    random_get_iarray(input, input_len);
-    // Optionally, rescale the input
-    for (int i = 0; i < input_len; ++i)
-    {
-      input[i] = input[i] % rescale_mod + rescale_offset;
-    }
-    // Reset the system counter to avoid overflows
-    DWT->CYCCNT = 0;
-    // Run the bench
-    benchmark((unsigned int *)input);
-    single_iter_lapse = DWT->CYCCNT;
-    printf("%lu\r\n", single_iter_lapse);
-  }
-}
-
-/**
- * @brief Runs the given benchmark, with integer inputs.
- *        A rescaling on the input is done as follows:
- *          input[i] = input[i] % rescale_mod
- *        thus allowing for arbitrary integer values.
- *        a rescale_offset is not needed
- *
- * @param benchmark: the main benchmark function
- * @param input_len: the length of the input for the benchmark
- * @param iter: the number of iterations: each iteration will have different input
- * @param rescale_mod: the range of integer values (from 0 to rescale_mod-1)
- */
-void bench_int_pathfind(void (*benchmark)(unsigned int *), uint32_t input_len,
-                          uint32_t iter, uint32_t rescale_mod)
-{
-  uint32_t input[input_len], single_iter_lapse;
-  for (int i = 0; i < iter; ++i)
-  {
-    // Randomize array
-    random_get_iarray(input, input_len);
-    // Optionally, rescale the input
-    for (int j = 0; j < 4; ++j)
-    {
-      input[j] = input[j] % rescale_mod;
-    }
-    // Generate the map
-    rescale_mod = 2;
-    for (int j = 4; j < input_len; ++j)
-    {
-      input[j] = input[j] % rescale_mod;
-    }
-    // Reset the system counter to avoid overflows
-    DWT->CYCCNT = 0;
-    // Run the bench
-    benchmark((unsigned int *)input);
-    single_iter_lapse = DWT->CYCCNT;
-    printf("%lu\r\n", single_iter_lapse);
-  }
-}
-
 PUTCHAR_PROTOTYPE
 {
-  if (HAL_UART_Transmit(&huart2, (uint8_t *)&ch, 1, 0xFFFF) != HAL_OK)
-  {
-    Error_Handler();
-  }
+  uart_tx_putchar(ch);
 
   return (ch);
 }
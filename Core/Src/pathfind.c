@@ -1,9 +1,8 @@
+#include <stddef.h>
 #include "pathfind.h"
+#include "kernel_placement.h"
 
-typedef struct
-{
-    int x, y;
-} Point;
+typedef pathfind_point_t Point;
 
 typedef struct
 {
@@ -12,41 +11,84 @@ typedef struct
     Point parent;
 } Node;
 
-int map[PATHFIND_HEIGHT][PATHFIND_WIDTH];
-Point start;
-Point goal;
+// Dimensioni della mappa (config 1 di default)
+static pathfind_config_t config = {.height = 5, .width = 5};
+
+// Numero massimo di celle della mappa
+#define MAX_CELLS (PATHFIND_MAX_HEIGHT * PATHFIND_MAX_WIDTH)
+
+// Le liste sono allocate sullo stack da pathfind(), dimensionate per la mappa
+// più grande, così che lo stack usato non dipenda dalla configurazione; le
+// celle sono indicizzate come y * width + x
+static int *map;
+static Point start;
+static Point goal;
 
 // Liste chiuse e aperte
-int closedList[PATHFIND_HEIGHT][PATHFIND_WIDTH] = {0}; // Lista chiusa
-Node openList[PATHFIND_WIDTH * PATHFIND_HEIGHT];       // Lista aperta
-Node closedNodes[PATHFIND_WIDTH * PATHFIND_HEIGHT];    // Lista dei nodi chiusi
-int openListSize = 0;
-int closedListSize = 0;
+static int *closedList;   // Lista chiusa
+static Node *openList;    // Lista aperta
+static Node *closedNodes; // Lista dei nodi chiusi
+static int openListSize = 0;
+static int closedListSize = 0;
 
-Point path[PATHFIND_WIDTH * PATHFIND_HEIGHT]; // Array statico per il percorso
-int pathLength = 0;         // Lunghezza del percorso
+static Point *path;        // Array per il percorso
+static int pathLength = 0; // Lunghezza del percorso
+
+#if KERNEL_OUTPUT_HOOKS
+// Destinatario dei percorsi (nessuno di default)
+static pathfind_output_t output_fn;
+#endif
+
+/**
+ * @brief Sets the dimensions of the map used by the next calls.
+ *
+ * @param cfg the new dimensions
+ * @return int: 0 on success, -1 if the dimensions exceed the maximum
+ */
+int pathfind_configure(const pathfind_config_t *cfg)
+{
+    if (cfg->height < 1 || cfg->height > PATHFIND_MAX_HEIGHT ||
+        cfg->width < 1 || cfg->width > PATHFIND_MAX_WIDTH)
+    {
+        return -1;
+    }
+    config = *cfg;
+    return 0;
+}
+
+/**
+ * @brief Sets the function that receives the paths of the next calls.
+ *
+ * @param output the receiver, or NULL
+ */
+#if KERNEL_OUTPUT_HOOKS
+void pathfind_set_output(pathfind_output_t output)
+{
+    output_fn = output;
+}
+#endif
 
 // Funzione per calcolare l'Heuristica (distanza euclidea)
-int calculateHeuristic(Point start, Point goal)
+static KERNEL_RAMFUNC int calculateHeuristic(Point start, Point goal)
 {
     return (start.x - goal.x) * (start.x - goal.x) + (start.y - goal.y) * (start.y - goal.y);
 }
 
 // Funzione per aggiungere un nodo alla lista aperta
-void addToOpenList(Node node)
+static KERNEL_RAMFUNC void addToOpenList(Node node)
 {
     openList[openListSize++] = node;
 }
 
 // Funzione per aggiungere un nodo alla lista chiusa
-void addToClosedList(Node node)
+static KERNEL_RAMFUNC void addToClosedList(Node node)
 {
     closedNodes[closedListSize++] = node;
-    closedList[node.point.y][node.point.x] = 1;
+    closedList[node.point.y * config.width + node.point.x] = 1;
 }
 
 // Funzione per trovare il nodo con il costo f più basso
-Node getLowestFCostNode()
+static KERNEL_RAMFUNC Node getLowestFCostNode()
 {
     int lowestIndex = 0;
     for (int i = 1; i < openListSize; i++)
@@ -66,25 +108,25 @@ Node getLowestFCostNode()
 }
 
 // Funzione per verificare se un punto è all'interno della mappa
-int isValid(Point p)
+static KERNEL_RAMFUNC int isValid(Point p)
 {
-    return p.x >= 0 && p.x < PATHFIND_WIDTH && p.y >= 0 && p.y < PATHFIND_HEIGHT;
+    return p.x >= 0 && p.x < config.width && p.y >= 0 && p.y < config.height;
 }
 
 // Funzione per verificare se un punto è un ostacolo
-int isObstacle(Point p)
+static KERNEL_RAMFUNC int isObstacle(Point p)
 {
-    return map[p.y][p.x] == 1; // 1 rappresenta un ostacolo
+    return map[p.y * config.width + p.x] == 1; // 1 rappresenta un ostacolo
 }
 
 // Funzione per verificare se due punti sono uguali
-int isEqual(Point a, Point b)
+static KERNEL_RAMFUNC int isEqual(Point a, Point b)
 {
     return a.x == b.x && a.y == b.y;
 }
 
 // Funzione per trovare un nodo nella lista chiusa
-Node getNodeFromClosedList(Point p)
+static KERNEL_RAMFUNC Node getNodeFromClosedList(Point p)
 {
     for (int i = 0; i < closedListSize; i++)
     {
@@ -99,7 +141,7 @@ Node getNodeFromClosedList(Point p)
 }
 
 // Funzione per trovare il percorso utilizzando l'algoritmo A*
-void aStar(Point start, Point goal)
+static KERNEL_RAMFUNC void aStar(Point start, Point goal)
 {
     Node startNode = {start, 0, calculateHeuristic(start, goal), calculateHeuristic(start, goal), {-1, -1}};
     addToOpenList(startNode);
@@ -107,6 +149,11 @@ void aStar(Point start, Point goal)
     while (openListSize > 0)
     {
         Node currentNode = getLowestFCostNode();
+        // A cell can be in the open list more than once: expand it only once
+        if (closedList[currentNode.point.y * config.width + currentNode.point.x])
+        {
+            continue;
+        }
         addToClosedList(currentNode);
 
         if (isEqual(currentNode.point, goal))
@@ -135,7 +182,7 @@ void aStar(Point start, Point goal)
         for (int i = 0; i < 4; i++)
         {
             Point neighbor = neighbors[i];
-            if (isValid(neighbor) && !isObstacle(neighbor) && !closedList[neighbor.y][neighbor.x])
+            if (isValid(neighbor) && !isObstacle(neighbor) && !closedList[neighbor.y * config.width + neighbor.x])
             {
                 int g_cost = currentNode.g_cost + 1;
                 int h_cost = calculateHeuristic(neighbor, goal);
@@ -149,33 +196,62 @@ void aStar(Point start, Point goal)
     }
 }
 
-void pathfind(unsigned int input[PATHFIND_INPUT_SIZE])
+KERNEL_RAMFUNC unsigned int pathfind(unsigned int input[])
 {
+    int cells = config.height * config.width;
+    int mapCells[MAX_CELLS];
+    int closedCells[MAX_CELLS];
+    Node openNodes[MAX_CELLS];
+    Node closedBuffer[MAX_CELLS];
+    Point pathPoints[MAX_CELLS];
+    map = mapCells;
+    closedList = closedCells;
+    openList = openNodes;
+    closedNodes = closedBuffer;
+    path = pathPoints;
+
+    // Reset the state left by the previous call
+    openListSize = 0;
+    closedListSize = 0;
+    pathLength = 0;
+    for (int i = 0; i < cells; ++i)
+    {
+        closedList[i] = 0;
+    }
+
     start.x = input[0];
     start.y = input[1];
     goal.x = input[2];
     goal.y = input[3];
 
-    int counter = 4;
-    for (int i = 0; i < PATHFIND_HEIGHT; ++i)
+    for (int i = 0; i < cells; ++i)
     {
-        for (int j = 0; j < PATHFIND_WIDTH; ++j)
-        {
-            map[i][j] = input[counter];
-            ++counter;
-        }
+        map[i] = input[4 + i];
     }
 
     if (!isValid(start) || isObstacle(start))
-        return;
+        return 0;
 
     if (!isValid(goal) || isObstacle(goal))
-        return;
+        return 0;
 
     if (start.x == goal.x && start.y == goal.y)
-        return;
+        return 0;
 
     aStar(start, goal);
+#if KERNEL_OUTPUT_HOOKS
+    if (output_fn != NULL)
+    {
+        output_fn(path, pathLength);
+    }
+#endif
 
-    return;
+    // Checksum dei nodi espansi e del percorso, perché la ricerca non venga
+    // eliminata dall'ottimizzatore anche quando il percorso non esiste
+    unsigned int checksum = closedListSize * 31 + pathLength;
+    for (int i = 0; i < pathLength; ++i)
+    {
+        checksum = checksum * 31 + path[i].y * config.width + path[i].x;
+    }
+    return checksum;
 }
@@ -0,0 +1,15 @@
+/**
+ * @file pathfind_ram.c
+ * @brief Copy of the kernel of pathfind.c placed in RAM, built with
+ * BENCH_RAM_KERNELS (see kernel_placement.h).
+ */
+
+#include "bench.h"
+
+#if BENCH_RAM_KERNELS
+#define KERNEL_RAMFUNC_SECTION ".RamFunc.pathfind"
+#define pathfind pathfind_ram
+#define pathfind_configure pathfind_configure_ram
+#define pathfind_set_output pathfind_set_output_ram
+#include "pathfind.c"
+#endif
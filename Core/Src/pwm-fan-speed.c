@@ -16,7 +16,9 @@
  */
 
 #include <math.h>
+#include <stddef.h>
 #include "pwm-fan-speed.h"
+#include "kernel_placement.h"
 
 // Air constants
 #define AIR_CP 1.012                  // [J/(Kg*K)]
@@ -45,21 +47,60 @@ typedef struct {
     double __prev_err;    // Previous error
 } status_t;
 
+// Parameters of the simulation (config 1 by default)
+static pwm_config_t config = {
+    .input_size = 100,
+    .temp_th = 50,
+    .airflow = 0.07,
+    .fan_area = 0.0113,   // circular area of a 12x12cm fan
+    .fan_distance = 0.1,
+};
+
+#if KERNEL_OUTPUT_HOOKS
+// Receiver of the steps (none by default)
+static pwm_output_t output_fn;
+#endif
+
 // int get_next_input_value(double *value, FILE *fp);
-double evaluate_temperature_increment(double heat_diff);
-double evaluate_natural_cooling(double temp);
-double evaluate_fan_cooling(fan_t fan, status_t status);
-double evaluate_new_dc(status_t *status, double th);
-double grashof(double temp);
-double reynolds(fan_t fan, double temp);
-
-void pwm_fan_speed(double input[PWM_INPUT_SIZE]) {
-    const double temp_th = PWM_TEMP_TH;
-    double airflow = PWM_AIRFLOW;
-    fan_t fan = {airflow / FAN_AREA, 0.0};
+static double evaluate_temperature_increment(double heat_diff);
+static double evaluate_natural_cooling(double temp);
+static double evaluate_fan_cooling(fan_t fan, status_t status);
+static double evaluate_new_dc(status_t *status, double th);
+static double grashof(double temp);
+static double reynolds(fan_t fan, double temp);
+
+/**
+ * @brief Sets the parameters used by the next simulations.
+ *
+ * @param cfg the new parameters
+ * @return int: 0 on success, -1 if the input size exceeds the maximum
+ */
+int pwm_configure(const pwm_config_t *cfg) {
+    if (cfg->input_size < 1 || cfg->input_size > PWM_MAX_INPUT_SIZE) {
+        return -1;
+    }
+    config = *cfg;
+    return 0;
+}
+
+/**
+ * @brief Sets the function that receives the steps of the next simulations.
+ *
+ * @param output the receiver, or NULL
+ */
+#if KERNEL_OUTPUT_HOOKS
+void pwm_set_output(pwm_output_t output) {
+    output_fn = output;
+}
+#endif
+
+KERNEL_RAMFUNC unsigned int pwm_fan_speed(double input[]) {
+    const double temp_th = config.temp_th;
+    double airflow = config.airflow;
+    fan_t fan = {airflow / config.fan_area, 0.0};
     status_t status = {AMBIENT_TEMP, AMBIENT_TEMP, 0, 0};
     double heat_diff, temp_delta, cooling, richardson;
-    for (int i = 0; i < PWM_INPUT_SIZE; ++i) {
+    for (int i = 0; i < config.input_size; ++i) {
         // Temperature increment
         heat_diff = input[i];
         temp_delta = evaluate_temperature_increment(heat_diff);
@@ -81,7 +122,18 @@ void pwm_fan_speed(double input[PWM_INPUT_SIZE]) {
         status.expected_temp -= evaluate_temperature_increment(cooling);
         // Evaluate new duty cycle
         fan.DC = evaluate_new_dc(&status, temp_th);
+#if KERNEL_OUTPUT_HOOKS
+        if (output_fn != NULL) {
+            output_fn(status.current_temp, status.expected_temp, fan.DC);
+        }
+#endif
     }
+    // Checksum of the final state, which depends on every step. The values
+    // are rounded, so that the last bits of pow() do not change it.
+    unsigned int checksum = (int)(status.current_temp * 1000);
+    checksum = checksum * 31 + (int)(status.expected_temp * 1000);
+    checksum = checksum * 31 + (int)(fan.DC * 10000);
+    return checksum;
 }
 
 /**
@@ -91,7 +143,7 @@ void pwm_fan_speed(double input[PWM_INPUT_SIZE]) {
  * @param th the threshold temperature
  * @return double: a value in the interval [0.0, 1.0]
  */
-double evaluate_new_dc(status_t *status, double th) {
+static KERNEL_RAMFUNC double evaluate_new_dc(status_t *status, double th) {
     double err = status->expected_temp - th;
     // Clipping to values above 0 since temperatures below the threshold
     // are ok
@@ -113,7 +165,7 @@ double evaluate_new_dc(status_t *status, double th) {
  * @param heat_diff the variation of heat
  * @return double: the temperature delta
  */
-double evaluate_temperature_increment(double heat_diff) {
+static KERNEL_RAMFUNC double evaluate_temperature_increment(double heat_diff) {
     return (heat_diff / ALUMINIUM_CP) * PWM_DT;
 }
 
@@ -123,7 +175,7 @@ double evaluate_temperature_increment(double heat_diff) {
  * @param temp the current temperature
  * @return double: the heat variation
  */
-double evaluate_natural_cooling(double temp) {
+static KERNEL_RAMFUNC double evaluate_natural_cooling(double temp) {
     double t_film = (temp + AMBIENT_TEMP) / 2 + K0;
     // Rayleigh number for natural convection
     double Ra = (g * (1 / t_film)) /
@@ -151,7 +203,7 @@ double evaluate_natural_cooling(double temp) {
  * @param temp the system's temperature
  * @return double: the Grashof number
  */
-double grashof(double temp) {
+static KERNEL_RAMFUNC double grashof(double temp) {
     double t_film = (temp + AMBIENT_TEMP) / 2 + K0;
     return ((g * (1 / t_film) * (temp - AMBIENT_TEMP) * pow(CHARACT_LEN, 3)) /
             pow(AIR_VISCOSITY * pow(t_film, 0.7355), 2));
@@ -164,7 +216,7 @@ double grashof(double temp) {
  * @param status the status of the system
  * @return double: the heat variation
  */
-double evaluate_fan_cooling(fan_t fan, status_t status) {
+static KERNEL_RAMFUNC double evaluate_fan_cooling(fan_t fan, status_t status) {
     // Reynolds number for forced convection
     double Re = reynolds(fan, status.expected_temp);
     double C, m, n;
@@ -177,7 +229,7 @@ double evaluate_fan_cooling(fan_t fan, status_t status) {
         C = 0.664, m = 0.5, n = 1.0 / 3;
     }
     double Nu = C * pow(Re, m) * pow(AIR_Pr, n);
-    double h = Nu * AIR_THERM_COND / FAN_DISTANCE;
+    double h = Nu * AIR_THERM_COND / config.fan_distance;
     return (h * SURFACE_AREA * (status.expected_temp - AMBIENT_TEMP));
 }
 
@@ -188,8 +240,8 @@ double evaluate_fan_cooling(fan_t fan, status_t status) {
  * @param temp the surface temperature
  * @return double: the Reynolds number
  */
-double reynolds(fan_t fan, double temp) {
+static KERNEL_RAMFUNC double reynolds(fan_t fan, double temp) {
     double t_film = (temp + AMBIENT_TEMP) / 2 + K0;
-    return (AIR_DENSITY * (fan.speed * fan.DC) * FAN_DISTANCE) /
+    return (AIR_DENSITY * (fan.speed * fan.DC) * config.fan_distance) /
            (AIR_VISCOSITY * pow(t_film, 0.7355));
 }
@@ -0,0 +1,15 @@
+/**
+ * @file pwm-fan-speed_ram.c
+ * @brief Copy of the kernel of pwm-fan-speed.c placed in RAM, built with
+ * BENCH_RAM_KERNELS (see kernel_placement.h).
+ */
+
+#include "bench.h"
+
+#if BENCH_RAM_KERNELS
+#define KERNEL_RAMFUNC_SECTION ".RamFunc.pwm_fan_speed"
+#define pwm_fan_speed pwm_fan_speed_ram
+#define pwm_configure pwm_configure_ram
+#define pwm_set_output pwm_set_output_ram
+#include "pwm-fan-speed.c"
+#endif
@@ -0,0 +1,75 @@
+/**
+ * @file uart_rx.c
+ * @brief Ring buffered, interrupt driven reception on USART2.
+ *
+ * The HAL receives one byte at a time into rx_byte; HAL_UART_RxCpltCallback()
+ * moves it to the buffer, which holds the bytes in [tail, head), and arms the
+ * next reception. A reception error (e.g. an overrun) stops the HAL's
+ * reception, so HAL_UART_ErrorCallback() arms it again.
+ */
+
+#include "main.h"
+#include "usart.h"
+#include "uart_rx.h"
+
+static uint8_t buffer[UART_RX_BUFFER_SIZE];
+static volatile uint32_t head; // Next free position (written by the IRQ)
+static volatile uint32_t tail; // First byte not yet read (written by the consumer)
+static uint8_t rx_byte;
+
+/**
+ * @brief Arms the reception of the next byte.
+ */
+static void receive_next(void)
+{
+  HAL_UART_Receive_IT(&huart2, &rx_byte, 1);
+}
+
+void HAL_UART_RxCpltCallback(UART_HandleTypeDef *huart)
+{
+  if (huart != &huart2)
+  {
+    return;
+  }
+  uint32_t next = (head + 1) % UART_RX_BUFFER_SIZE;
+  if (next != tail)
+  {
+    buffer[head] = rx_byte;
+    head = next;
+  }
+  receive_next();
+}
+
+void HAL_UART_ErrorCallback(UART_HandleTypeDef *huart)
+{
+  if (huart != &huart2)
+  {
+    return;
+  }
+  receive_next();
+}
+
+/**
+ * @brief Starts the reception, discarding anything received before.
+ */
+void uart_rx_start(void)
+{
+  tail = head;
+  receive_next();
+}
+
+/**
+ * @brief Takes the next received byte, without waiting.
+ *
+ * @return int: the byte, or -1 if nothing was received
+ */
+int uart_rx_getchar(void)
+{
+  if (tail == head)
+  {
+    return -1;
+  }
+  uint8_t ch = buffer[tail];
+  tail = (tail + 1) % UART_RX_BUFFER_SIZE;
+  return ch;
+}
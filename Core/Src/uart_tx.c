@@ -0,0 +1,95 @@
+/**
+ * @file uart_tx.c
+ * @brief Ring buffered, DMA driven transmission on USART2.
+ *
+ * The buffer holds the bytes in [tail, head). The DMA sends the contiguous
+ * chunk that starts at tail; when it completes, HAL_UART_TxCpltCallback()
+ * releases the chunk and starts the next one.
+ */
+
+#include "main.h"
+#include "usart.h"
+#include "uart_tx.h"
+
+static uint8_t buffer[UART_TX_BUFFER_SIZE];
+static volatile uint32_t head;      // Next free position (written by the producer)
+static volatile uint32_t tail;      // First byte not yet sent (written by the IRQ)
+static volatile uint32_t in_flight; // Bytes being sent by the DMA, 0 if idle
+
+/**
+ * @brief Starts the DMA on the next contiguous chunk, if the DMA is idle and
+ *        there is something to send. To be called with interrupts disabled or
+ *        from the transfer complete interrupt.
+ */
+static void start_dma(void)
+{
+  if (in_flight != 0 || head == tail)
+  {
+    return;
+  }
+  uint32_t end = head > tail ? head : UART_TX_BUFFER_SIZE;
+  in_flight = end - tail;
+  if (HAL_UART_Transmit_DMA(&huart2, &buffer[tail], in_flight) != HAL_OK)
+  {
+    Error_Handler();
+  }
+}
+
+void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart)
+{
+  if (huart != &huart2)
+  {
+    return;
+  }
+  tail = (tail + in_flight) % UART_TX_BUFFER_SIZE;
+  in_flight = 0;
+  start_dma();
+}
+
+/**
+ * @brief Queues a byte for transmission. Returns immediately, unless the
+ *        buffer is full.
+ *
+ * @param ch: the byte to send
+ */
+void uart_tx_putchar(uint8_t ch)
+{
+  uint32_t next = (head + 1) % UART_TX_BUFFER_SIZE;
+  while (next == tail)
+  {
+    // Buffer full: wait for the DMA to release some space
+  }
+  buffer[head] = ch;
+  head = next;
+  if (in_flight == 0)
+  {
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    start_dma();
+    __set_PRIMASK(primask);
+  }
+}
+
+/**
+ * @brief Queues a block of bytes for transmission.
+ *
+ * @param data: the bytes to send
+ * @param len: the number of bytes
+ */
+void uart_tx_write(const uint8_t *data, uint32_t len)
+{
+  for (uint32_t i = 0; i < len; ++i)
+  {
+    uart_tx_putchar(data[i]);
+  }
+}
+
+/**
+ * @brief Waits until all the queued bytes have been sent.
+ */
+void uart_tx_flush(void)
+{
+  while (in_flight != 0 || head != tail)
+  {
+  }
+}
@@ -6,7 +6,9 @@
  */
 
 #include <math.h>
+#include <stddef.h>
 #include "visualizer.h"
+#include "kernel_placement.h"
 
 typedef struct {
     int x_factor;    // The scaling factor for the x axis
@@ -14,45 +16,90 @@ typedef struct {
     double min;      // The minimum value found so far
 } image_data;
 
-image_data im_data;
+static image_data im_data;
 
+// Dimensions of the image and length of the input (config 1 by default)
+static vis_config_t config = {.width = 300, .height = 200, .input_size = 100};
 
-void get_values(double input[VIS_INPUT_SIZE], int n, double *min, double *max);
-void draw_line(char image[VIS_HEIGHT][VIS_WIDTH], int x_0, double y_0,
-               double y_1);
+#if KERNEL_OUTPUT_HOOKS
+// Receiver of the images (none by default)
+static vis_output_t output_fn;
+#endif
 
-void visualizer(double input[VIS_INPUT_SIZE]) {
-    char image[VIS_HEIGHT][VIS_WIDTH];
-    for (int i = 0; i < VIS_HEIGHT; ++i) {
-        for (int j = 0; j < VIS_WIDTH; ++j) {
+
+static void get_values(double input[], int n, double *min, double *max);
+static unsigned int draw_line(int height, int width, char image[height][width],
+                              int x_0, double y_0, double y_1);
+
+/**
+ * @brief Sets the dimensions of the image and the length of the input used
+ * by the next calls.
+ *
+ * @param cfg the new configuration
+ * @return int: 0 on success, -1 if a value exceeds the maximum
+ */
+int visualizer_configure(const vis_config_t *cfg) {
+    if (cfg->width < 1 || cfg->width > VIS_MAX_WIDTH || cfg->height < 1 ||
+        cfg->height > VIS_MAX_HEIGHT ||
+        cfg->width * cfg->height > VIS_MAX_AREA || cfg->input_size < 2 ||
+        cfg->input_size > VIS_MAX_INPUT_SIZE) {
+        return -1;
+    }
+    config = *cfg;
+    return 0;
+}
+
+/**
+ * @brief Sets the function that receives the image drawn by the next calls.
+ *
+ * @param output the receiver, or NULL
+ */
+#if KERNEL_OUTPUT_HOOKS
+void visualizer_set_output(vis_output_t output) {
+    output_fn = output;
+}
+#endif
+
+KERNEL_RAMFUNC unsigned int visualizer(double input[]) {
+    const int height = config.height, width = config.width;
+    char image[height][width];
+    for (int i = 0; i < height; ++i) {
+        for (int j = 0; j < width; ++j) {
             image[i][j] = '0';
         }
     }
     double y_max;
     // Check if time series fits horizontally
-    int x_max = VIS_INPUT_SIZE;
-    if (VIS_INPUT_SIZE > VIS_WIDTH) {
+    int x_max = config.input_size;
+    if (config.input_size > width) {
         // Input too big for the picture: truncating to the values compatible
         // with the width of the image
-        x_max = VIS_WIDTH;
+        x_max = width;
         // Find the maximum and the minimum, again
         // Scale maximum and minimum according to size of the image
     }
     get_values(input, x_max, &y_max, &im_data.min);
-    im_data.x_factor = VIS_WIDTH / x_max; // >= 1
+    im_data.x_factor = width / x_max; // >= 1
     if (im_data.min == y_max) {
         // Constant value, to be plot in the half of the image as a line
-        im_data.min -= (VIS_HEIGHT - 1) / 2.0;
+        im_data.min -= (height - 1) / 2.0;
         im_data.y_factor = 1;
     } else {
         // To scale a y value, the used formula is:
         // y_scaled = (height-1)*(y-min)/(max - min)
-        im_data.y_factor = (VIS_HEIGHT - 1) / (y_max - im_data.min);
+        im_data.y_factor = (height - 1) / (y_max - im_data.min);
     }
     // For each couple of point of the input draw a line
+    unsigned int checksum = 0;
     for (int i = 1; i < x_max; ++i) {
-        draw_line(image, i, input[i - 1], input[i]);
+        checksum += draw_line(height, width, image, i, input[i - 1], input[i]);
+    }
+#if KERNEL_OUTPUT_HOOKS
+    if (output_fn != NULL) {
+        output_fn(height, width, &image[0][0]);
     }
+#endif
+    return checksum;
 }
 
 /**
@@ -62,7 +109,7 @@ void visualizer(double input[VIS_INPUT_SIZE]) {
  * @param min the minimum found input value
  * @param max the maximum found input value
  */
-void get_values(double input[VIS_INPUT_SIZE], int n, double *min, double *max) {
+static KERNEL_RAMFUNC void get_values(double input[], int n, double *min, double *max) {
     *min = INFINITY;
     *max = -INFINITY;
     for (int i = 0; i < n; ++i) {
@@ -78,19 +125,24 @@ void get_values(double input[VIS_INPUT_SIZE], int n, double *min, double *max) {
 /**
  * @brief Draw a line, using the Bresenham's Line Drawing algorithm.
  *
+ * @param height the height of the image
+ * @param width the width of the image
  * @param image the image representation
  * @param x_0 the final x value (used to find the start)
  * @param y_0 the first y value
  * @param y_1 the second y value
+ * @return unsigned int: the position (y * width + x) of the last pixel of the
+ * line, for the checksum of the image (the stores to the image are kept alive
+ * by the output hook, which may receive it)
  */
-void draw_line(char image[VIS_HEIGHT][VIS_WIDTH], int x_1, double y_0,
-               double y_1) {
+static KERNEL_RAMFUNC unsigned int draw_line(int height, int width, char image[height][width],
+                                             int x_1, double y_0, double y_1) {
     x_1 *= im_data.x_factor;
     int x = x_1 - im_data.x_factor;
     int dx = im_data.x_factor;
     int sign_x = 1;
-    int y = VIS_HEIGHT - (im_data.y_factor * (y_0 - im_data.min)) - 1;
-    int y1 = VIS_HEIGHT - (im_data.y_factor * (y_1 - im_data.min)) - 1;
+    int y = height - (im_data.y_factor * (y_0 - im_data.min)) - 1;
+    int y1 = height - (im_data.y_factor * (y_1 - im_data.min)) - 1;
     int dy = -(y1 - y);
     if (dy > 0) {
         dy *= -1;
@@ -101,7 +153,7 @@ void draw_line(char image[VIS_HEIGHT][VIS_WIDTH], int x_1, double y_0,
     while (1) {
         image[y][x] = '1';
         if (x == x_1 && y == y1) {
-            break;
+            return y * width + x;
         }
         e2 = 2 * err;
         if (e2 >= dy) {
@@ -0,0 +1,15 @@
+/**
+ * @file visualizer_ram.c
+ * @brief Copy of the kernel of visualizer.c placed in RAM, built with
+ * BENCH_RAM_KERNELS (see kernel_placement.h).
+ */
+
+#include "bench.h"
+
+#if BENCH_RAM_KERNELS
+#define KERNEL_RAMFUNC_SECTION ".RamFunc.visualizer"
+#define visualizer visualizer_ram
+#define visualizer_configure visualizer_configure_ram
+#define visualizer_set_output visualizer_set_output_ram
+#include "visualizer.c"
+#endif
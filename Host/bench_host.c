@@ -0,0 +1,616 @@
+/**
+ * @file bench_host.c
+ * @brief Hosted driver of the benchmark registry, for Linux.
+ *
+ * Runs the kernels of Core/Src, unchanged, with the registry and the
+ * iteration loop of the firmware: the input of iteration i of every run is
+ * generated from bench_iteration_seed(seed, i), so a host run sees the same
+ * inputs as a board run with the same seed. Each call is timed with
+ * clock_gettime() in nanoseconds, or with the TSC on x86-64 (-t tsc), minus
+ * the overhead of an empty timed window measured for each input type. As on
+ * the firmware, entries with BENCH_REPEAT_AUTO call the kernel enough times
+ * per window to reach BENCH_TARGET_WINDOW timer units, based on a pilot call.
+ *
+ * The samples of each run are written to <outdir>/<short_name>_<config>.csv
+ * (pathfind_1.csv, ...), named like the files in measurements/, with one
+ * value per line as in those of Tools/bench_frames.py, and the summary line
+ * of the run is printed in the firmware's format, including the checksum of
+ * the outputs.
+ *
+ * With -p, the hardware counters of host_perf.h are read around each timed
+ * window as well, minus those of the empty window. They are appended to the
+ * lines of the CSV files (time,cycles,instructions,l1d_misses,llc_misses,
+ * branch_misses; empty when unavailable), and a "Counters" line follows the
+ * summary line of each run with their means per call and the ratios that tell
+ * a memory-bound kernel from a branch-bound one: instructions per cycle and
+ * misses per thousand instructions (MPKI).
+ *
+ * With -i index, the input of that iteration is regenerated from its seed and
+ * timed -n times instead, as bench_replay() does on the firmware
+ * (BENCH_REPLAY), to look into an outlier of a run: a "Replay" line is printed
+ * for each measurement, then the summary line, and no CSV file is written.
+ *
+ * Usage: bench_host [-n iterations] [-s seed] [-w warmup] [-e entry]
+ *                   [-i index] [-t ns|tsc] [-p] [-o outdir]
+ */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+#include "bench.h"
+#include "bench_stats.h"
+#include "host_perf.h"
+#include "simple_random.h"
+#include "visualizer.h"
+#include "pwm-fan-speed.h"
+#include "huffman-compression.h"
+#include "pathfind.h"
+
+#define MAX(a, b) ((a) > (b) ? (a) : (b))
+
+// Largest input allowed by the kernels, in 8-byte words
+#define ARENA_WORDS                                                                         \
+  ((MAX(MAX(VIS_MAX_INPUT_SIZE * sizeof(double), PWM_MAX_INPUT_SIZE * sizeof(double)),     \
+        MAX(HUFFMAN_MAX_INPUT_SIZE * sizeof(unsigned int),                                  \
+            PATHFIND_MAX_INPUT_SIZE * sizeof(unsigned int))) + 7) / 8)
+
+// Number of runs of the empty kernel used to measure the timer overhead
+#define CALIBRATION_ITERS 1000
+
+typedef enum
+{
+  TIMER_NS, // clock_gettime(CLOCK_MONOTONIC)
+  TIMER_TSC // Time stamp counter
+} host_timer_t;
+
+static uint64_t arena[ARENA_WORDS];
+static host_timer_t timer = TIMER_NS;
+// Time spent by an empty kernel in the timed window, for each input type
+static uint64_t overhead[2];
+// Time added by each further inner repeat of an empty kernel
+static uint64_t repeat_overhead[2];
+// Read the hardware counters (-p)
+static int perf;
+static host_perf_sample_t perf_overhead[2];
+// Windows in which the counters could not be read
+static uint32_t perf_failures;
+// Checksum returned by the last kernel call (see bench.c)
+static volatile unsigned int sink;
+
+static uint64_t now(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+  if (timer == TIMER_TSC)
+  {
+    // Keep the kernel from moving across the reads
+    _mm_lfence();
+    uint64_t tsc = __rdtsc();
+    _mm_lfence();
+    return tsc;
+  }
+#endif
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+
+/**
+ * @brief Measures back-to-back calls of the kernel on the same input.
+ *
+ * @param counters: the values of the hardware counters over the window, with
+ *        -p; may be NULL
+ * @return uint64_t: the elapsed time, in timer units
+ */
+static uint64_t measure(const bench_t *bench, void *input, uint32_t repeat,
+                        host_perf_sample_t *counters)
+{
+  // The counters are started first, so that the system calls that drive
+  // them stay out of the timed window
+  if (perf)
+  {
+    host_perf_start();
+  }
+  uint64_t start = now();
+  if (bench->input_type == BENCH_INPUT_DOUBLE)
+  {
+    for (uint32_t r = 0; r < repeat; ++r)
+    {
+      sink = bench->run.f64((double *)input);
+    }
+  }
+  else
+  {
+    for (uint32_t r = 0; r < repeat; ++r)
+    {
+      sink = bench->run.u32((unsigned int *)input);
+    }
+  }
+  uint64_t t = now() - start;
+  if (perf)
+  {
+    host_perf_sample_t sample;
+    if (host_perf_stop(&sample) != 0)
+    {
+      ++perf_failures;
+    }
+    if (counters != NULL)
+    {
+      *counters = sample;
+    }
+  }
+  return t;
+}
+
+// Empty kernels, used to measure the overhead of the timed window
+__attribute__((noinline)) static unsigned int empty_f64(double *input)
+{
+  __asm volatile("" : : "r"(input) : "memory");
+  return 0;
+}
+
+__attribute__((noinline)) static unsigned int empty_u32(unsigned int *input)
+{
+  __asm volatile("" : : "r"(input) : "memory");
+  return 0;
+}
+
+/**
+ * @brief Minimum time, and counters, of CALIBRATION_ITERS measurements of an
+ *        empty kernel.
+ */
+static uint64_t measure_empty(const bench_t *empty, uint32_t repeat, host_perf_sample_t *min_counters)
+{
+  uint64_t min = UINT64_MAX;
+  for (int e = 0; e < HOST_PERF_EVENTS; ++e)
+  {
+    min_counters->values[e] = UINT64_MAX;
+  }
+  for (uint32_t i = 0; i < CALIBRATION_ITERS; ++i)
+  {
+    host_perf_sample_t counters;
+    uint64_t t = measure(empty, arena, repeat, &counters);
+    min = t < min ? t : min;
+    for (int e = 0; perf && e < HOST_PERF_EVENTS; ++e)
+    {
+      if (counters.values[e] < min_counters->values[e])
+      {
+        min_counters->values[e] = counters.values[e];
+      }
+    }
+  }
+  return min;
+}
+
+/**
+ * @brief Measures the time, and counters, of the timed window around an empty
+ *        kernel of each input type, and the time of each further inner
+ *        repeat, subtracted from every sample as bench.c does.
+ */
+static void calibrate(void)
+{
+  static const bench_t empty[] = {
+    [BENCH_INPUT_DOUBLE] = {.name = "Empty", .input_type = BENCH_INPUT_DOUBLE, .run.f64 = empty_f64},
+    [BENCH_INPUT_UINT] = {.name = "Empty", .input_type = BENCH_INPUT_UINT, .run.u32 = empty_u32},
+  };
+  const char *unit = timer == TIMER_TSC ? "ticks" : "ns";
+  for (uint32_t type = 0; type < 2; ++type)
+  {
+    host_perf_sample_t batch_counters;
+    overhead[type] = measure_empty(&empty[type], 1, &perf_overhead[type]);
+    uint64_t batch = measure_empty(&empty[type], 17, &batch_counters);
+    repeat_overhead[type] = batch > overhead[type] ? (batch - overhead[type]) / 16 : 0;
+  }
+  printf("Timer overhead: %" PRIu64 " %s (double input), %" PRIu64 " %s (unsigned int input)\n",
+         overhead[BENCH_INPUT_DOUBLE], unit, overhead[BENCH_INPUT_UINT], unit);
+  printf("Inner repeat overhead: %" PRIu64 " %s (double input), %" PRIu64
+         " %s (unsigned int input)\n",
+         repeat_overhead[BENCH_INPUT_DOUBLE], unit, repeat_overhead[BENCH_INPUT_UINT], unit);
+  for (uint32_t type = 0; perf && type < 2; ++type)
+  {
+    printf("Counters overhead (%s input):", type == BENCH_INPUT_DOUBLE ? "double" : "unsigned int");
+    for (int e = 0; e < HOST_PERF_EVENTS; ++e)
+    {
+      if (host_perf_available(e))
+      {
+        printf(" %s=%" PRIu64, host_perf_name(e), perf_overhead[type].values[e]);
+      }
+    }
+    printf("\n");
+  }
+}
+
+/**
+ * @brief Removes the overhead of the timed window from a measurement.
+ *
+ * @return uint64_t: the average time of one call of the kernel
+ */
+static uint64_t net_time(const bench_t *bench, uint64_t t, uint32_t repeat)
+{
+  uint64_t cost = overhead[bench->input_type] + (repeat - 1) * repeat_overhead[bench->input_type];
+  return t > cost ? (t - cost) / repeat : 0;
+}
+
+/**
+ * @brief Removes the counts of the empty timed window from the counters of a
+ *        measurement, and averages them over the calls.
+ */
+static void net_counters(const bench_t *bench, const host_perf_sample_t *sample, uint32_t repeat,
+                         host_perf_sample_t *counters)
+{
+  for (int e = 0; e < HOST_PERF_EVENTS; ++e)
+  {
+    uint64_t v = sample->values[e], o = perf_overhead[bench->input_type].values[e];
+    counters->values[e] = (v > o ? v - o : 0) / repeat;
+  }
+}
+
+/**
+ * @brief Prints the means per call of the counters of a run, and their
+ *        ratios.
+ */
+static void print_counters(const bench_t *bench, const host_perf_sample_t *counters,
+                           uint32_t count)
+{
+  double mean[HOST_PERF_EVENTS] = {0};
+  for (uint32_t i = 0; i < count; ++i)
+  {
+    for (int e = 0; e < HOST_PERF_EVENTS; ++e)
+    {
+      mean[e] += (double)counters[i].values[e] / count;
+    }
+  }
+  printf("Counters %s config %" PRIu32 ":", bench->name, bench->config);
+  for (int e = 0; e < HOST_PERF_EVENTS; ++e)
+  {
+    if (host_perf_available(e))
+    {
+      printf(" %s=%.0f", host_perf_name(e), mean[e]);
+    }
+    else
+    {
+      printf(" %s=n/a", host_perf_name(e));
+    }
+  }
+  double insns = mean[HOST_PERF_INSTRUCTIONS];
+  if (host_perf_available(HOST_PERF_INSTRUCTIONS) && insns > 0)
+  {
+    if (host_perf_available(HOST_PERF_CYCLES) && mean[HOST_PERF_CYCLES] > 0)
+    {
+      printf(" ipc=%.2f", insns / mean[HOST_PERF_CYCLES]);
+    }
+    const host_perf_event_t misses[] = {HOST_PERF_L1D_MISSES, HOST_PERF_LLC_MISSES,
+                                        HOST_PERF_BRANCH_MISSES};
+    const char *names[] = {"l1d_mpki", "llc_mpki", "branch_mpki"};
+    for (int m = 0; m < 3; ++m)
+    {
+      if (host_perf_available(misses[m]))
+      {
+        printf(" %s=%.2f", names[m], mean[misses[m]] * 1000 / insns);
+      }
+    }
+  }
+  printf("\n");
+}
+
+static void generate(const bench_t *bench, void *input, uint32_t seed, uint32_t index)
+{
+  random_set_seed(bench_iteration_seed(seed, index));
+  bench->generate(bench, input);
+}
+
+/**
+ * @brief Chooses the number of inner repeats of a benchmark: the one set in
+ *        the registry, or the one that makes the timed window about
+ *        BENCH_TARGET_WINDOW timer units long, based on a pilot call on the
+ *        input of iteration 0 (see choose_repeat() in bench.c).
+ */
+static uint32_t choose_repeat(const bench_t *bench, uint32_t seed)
+{
+  if (bench->repeat != BENCH_REPEAT_AUTO)
+  {
+    return bench->repeat;
+  }
+  generate(bench, arena, seed, 0);
+  uint64_t t = measure(bench, arena, 1, NULL);
+  if (t >= BENCH_TARGET_WINDOW)
+  {
+    return 1;
+  }
+  return BENCH_TARGET_WINDOW / (t > 0 ? t : 1);
+}
+
+/**
+ * @brief Writes the samples of a run to <outdir>/<short_name>_<config>.csv,
+ *        named like the files in measurements/.
+ *
+ * @return int: 0 on success, -1 if the file cannot be written
+ */
+static int write_csv(const char *outdir, const bench_t *bench, const uint64_t *samples,
+                     const host_perf_sample_t *counters, uint32_t count)
+{
+  char path[4096];
+  snprintf(path, sizeof(path), "%s/%s_%" PRIu32 ".csv", outdir, bench->short_name,
+           bench->config);
+  FILE *f = fopen(path, "w");
+  if (f == NULL)
+  {
+    perror(path);
+    return -1;
+  }
+  for (uint32_t i = 0; i < count; ++i)
+  {
+    fprintf(f, "%" PRIu64, samples[i]);
+    for (int e = 0; counters != NULL && e < HOST_PERF_EVENTS; ++e)
+    {
+      if (host_perf_available(e))
+      {
+        fprintf(f, ",%" PRIu64, counters[i].values[e]);
+      }
+      else
+      {
+        fputc(',', f);
+      }
+    }
+    fputc('\n', f);
+  }
+  return fclose(f) == 0 ? 0 : -1;
+}
+
+/**
+ * @brief Prints the summary line of a run, in the firmware's format.
+ */
+static void print_stats(const bench_t *bench, const bench_stats_t *stats, uint32_t checksum)
+{
+  printf("Stats %s config %" PRIu32 ": n=%" PRIu32 " min=%" PRIu64 " max=%" PRIu64
+         " mean=%.0f stddev=%.0f p50=%.0f p90=%.0f p99=%.0f checksum=%08" PRIx32 "\n",
+         bench->name, bench->config, stats->count, stats->count ? stats->min : 0, stats->max,
+         stats->mean, bench_stats_stddev(stats), bench_p2_get(&stats->p50),
+         bench_p2_get(&stats->p90), bench_p2_get(&stats->p99), checksum);
+}
+
+/**
+ * @brief Configures the kernel, chooses the inner repeats of a run and warms
+ *        the kernel up.
+ *
+ * @param repeat: where to store the number of calls per timed window
+ * @return int: 0 on success, -1 if the configuration was rejected
+ */
+static int prepare(const bench_t *bench, uint32_t seed, uint32_t warmup, uint32_t *repeat)
+{
+  if (bench->configure != NULL && bench->configure(bench) != 0)
+  {
+    fprintf(stderr, "Invalid config %" PRIu32 " of %s\n", bench->config, bench->name);
+    return -1;
+  }
+  *repeat = choose_repeat(bench, seed);
+  printf("Inner repeats: %" PRIu32 "\n", *repeat);
+  for (uint32_t i = 0; i < warmup; ++i)
+  {
+    generate(bench, arena, seed, i);
+    measure(bench, arena, *repeat, NULL);
+  }
+  return 0;
+}
+
+/**
+ * @brief Runs a benchmark: warmup iterations, then the measured ones.
+ *
+ * @return int: 0 on success, -1 if the configuration was rejected or the
+ *         samples cannot be written
+ */
+static int run(const bench_t *bench, uint32_t iter, uint32_t seed, uint32_t warmup,
+               const char *outdir)
+{
+  uint32_t repeat;
+  if (prepare(bench, seed, warmup, &repeat) != 0)
+  {
+    return -1;
+  }
+  uint64_t *samples = malloc(iter * sizeof(samples[0]));
+  host_perf_sample_t *counters = perf ? malloc(iter * sizeof(counters[0])) : NULL;
+  if (samples == NULL || (perf && counters == NULL))
+  {
+    perror("malloc");
+    free(samples);
+    free(counters);
+    return -1;
+  }
+  perf_failures = 0;
+  bench_stats_t stats;
+  bench_stats_init(&stats);
+  uint32_t checksum = BENCH_CHECKSUM_INIT;
+  for (uint32_t i = 0; i < iter; ++i)
+  {
+    generate(bench, arena, seed, i);
+    host_perf_sample_t sample;
+    uint64_t t = measure(bench, arena, repeat, &sample);
+    checksum = bench_fold_checksum(checksum, sink);
+    samples[i] = net_time(bench, t, repeat);
+    bench_stats_add(&stats, samples[i]);
+    if (perf)
+    {
+      net_counters(bench, &sample, repeat, &counters[i]);
+    }
+  }
+  print_stats(bench, &stats, checksum);
+  if (perf)
+  {
+    print_counters(bench, counters, iter);
+    if (perf_failures > 0)
+    {
+      printf("Counters not read in %" PRIu32 " windows (multiplexed?)\n", perf_failures);
+    }
+  }
+  int ret = write_csv(outdir, bench, samples, counters, iter);
+  free(samples);
+  free(counters);
+  return ret;
+}
+
+/**
+ * @brief Regenerates the input of a single iteration of a run from its seed
+ *        and times it again, as bench_replay() does on the firmware. Inner
+ *        repeats and warmup are the same as in run().
+ *
+ * @param index: the index of the iteration in the run
+ * @param times: the number of measurements of the iteration
+ * @return int: 0 on success, -1 if the configuration was rejected
+ */
+static int replay(const bench_t *bench, uint32_t index, uint32_t times, uint32_t seed,
+                  uint32_t warmup)
+{
+  uint32_t repeat;
+  if (prepare(bench, seed, warmup, &repeat) != 0)
+  {
+    return -1;
+  }
+  host_perf_sample_t *counters = perf ? malloc(times * sizeof(counters[0])) : NULL;
+  if (perf && counters == NULL)
+  {
+    perror("malloc");
+    return -1;
+  }
+  perf_failures = 0;
+  bench_stats_t stats;
+  bench_stats_init(&stats);
+  generate(bench, arena, seed, index);
+  for (uint32_t i = 0; i < times; ++i)
+  {
+    host_perf_sample_t sample;
+    uint64_t t = net_time(bench, measure(bench, arena, repeat, &sample), repeat);
+    bench_stats_add(&stats, t);
+    if (perf)
+    {
+      net_counters(bench, &sample, repeat, &counters[i]);
+    }
+    printf("Replay %s config %" PRIu32 " iteration %" PRIu32 " seed %" PRIu32 ": %" PRIu64 "\n",
+           bench->name, bench->config, index, bench_iteration_seed(seed, index), t);
+  }
+  // The checksum of the iteration alone, as the output does not change
+  print_stats(bench, &stats, sink);
+  if (perf)
+  {
+    print_counters(bench, counters, times);
+    if (perf_failures > 0)
+    {
+      printf("Counters not read in %" PRIu32 " windows (multiplexed?)\n", perf_failures);
+    }
+  }
+  free(counters);
+  return 0;
+}
+
+static void usage(const char *argv0)
+{
+  fprintf(stderr,
+          "Usage: %s [-n iterations] [-s seed] [-w warmup] [-e entry] [-i index] "
+          "[-t ns|tsc] [-p] [-o outdir]\n",
+          argv0);
+  exit(2);
+}
+
+int main(int argc, char *argv[])
+{
+  uint32_t iter = 1000, seed = BENCH_SEED, warmup = BENCH_WARMUP;
+  long entry = -1, index = -1;
+  const char *outdir = ".";
+  int opt;
+  while ((opt = getopt(argc, argv, "n:s:w:e:i:t:po:")) != -1)
+  {
+    switch (opt)
+    {
+    case 'n':
+      iter = strtoul(optarg, NULL, 10);
+      break;
+    case 's':
+      seed = strtoul(optarg, NULL, 10);
+      break;
+    case 'w':
+      warmup = strtoul(optarg, NULL, 10);
+      break;
+    case 'e':
+      entry = strtol(optarg, NULL, 10);
+      break;
+    case 'i':
+      index = strtol(optarg, NULL, 10);
+      if (index < 0)
+      {
+        usage(argv[0]);
+      }
+      break;
+    case 't':
+      if (strcmp(optarg, "ns") == 0)
+      {
+        timer = TIMER_NS;
+      }
+#if defined(__x86_64__) || defined(__i386__)
+      else if (strcmp(optarg, "tsc") == 0)
+      {
+        timer = TIMER_TSC;
+      }
+#endif
+      else
+      {
+        usage(argv[0]);
+      }
+      break;
+    case 'p':
+      perf = 1;
+      break;
+    case 'o':
+      outdir = optarg;
+      break;
+    default:
+      usage(argv[0]);
+    }
+  }
+  if (iter == 0 || entry >= (long)bench_registry_len)
+  {
+    usage(argv[0]);
+  }
+  if (perf)
+  {
+    if (host_perf_open() < 0)
+    {
+      perror("perf_event_open");
+      return 1;
+    }
+    for (int e = 0; e < HOST_PERF_EVENTS; ++e)
+    {
+      if (!host_perf_available(e))
+      {
+        fprintf(stderr, "Counter %s unavailable\n", host_perf_name(e));
+      }
+    }
+  }
+  calibrate();
+  int ret = 0;
+  for (uint32_t i = 0; i < bench_registry_len; ++i)
+  {
+    if (entry >= 0 && i != (uint32_t)entry)
+    {
+      continue;
+    }
+    const bench_t *bench = &bench_registry[i];
+    printf("Seed: %" PRIu32 "\n", seed);
+    printf("Start bench %s config %" PRIu32 "\n", bench->name, bench->config);
+    int status = index >= 0 ? replay(bench, index, iter, seed, warmup)
+                            : run(bench, iter, seed, warmup, outdir);
+    if (status != 0)
+    {
+      ret = 1;
+    }
+    printf("Done bench %s config %" PRIu32 "\n", bench->name, bench->config);
+  }
+  if (perf)
+  {
+    host_perf_close();
+  }
+  return ret;
+}
@@ -0,0 +1,153 @@
+/**
+ * @file host_perf.c
+ * @brief Hardware performance counters of the host harness. See host_perf.h.
+ */
+
+#include <errno.h>
+#include <linux/perf_event.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include "host_perf.h"
+
+#define CACHE_READ_MISS(cache)                                                               \
+  ((cache) | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16))
+
+/**
+ * @brief perf_event_attr type and config of a counter.
+ */
+typedef struct
+{
+  const char *name;
+  uint32_t type;
+  uint64_t config;
+} event_desc_t;
+
+static const event_desc_t events[HOST_PERF_EVENTS] = {
+  [HOST_PERF_CYCLES] = {"cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+  [HOST_PERF_INSTRUCTIONS] = {"instructions", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+  [HOST_PERF_L1D_MISSES] = {"l1d_misses", PERF_TYPE_HW_CACHE,
+                            CACHE_READ_MISS(PERF_COUNT_HW_CACHE_L1D)},
+  [HOST_PERF_LLC_MISSES] = {"llc_misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+  [HOST_PERF_BRANCH_MISSES] = {"branch_misses", PERF_TYPE_HARDWARE,
+                               PERF_COUNT_HW_BRANCH_MISSES},
+};
+
+// File descriptors of the counters, -1 if unavailable; the leader is the
+// first available one
+static int fds[HOST_PERF_EVENTS] = {[0 ... HOST_PERF_EVENTS - 1] = -1};
+static int leader = -1;
+// Number of counters in the group, read in the order of the events
+static int opened;
+
+static int perf_event_open(struct perf_event_attr *attr, int group_fd)
+{
+  // This thread, on any CPU
+  return syscall(SYS_perf_event_open, attr, 0, -1, group_fd, 0);
+}
+
+/**
+ * @brief Opens the group of counters, disabled.
+ *
+ * @return int: the number of available counters, or -1 if none can be
+ *         opened (errno is set)
+ */
+int host_perf_open(void)
+{
+  int err = 0;
+  opened = 0;
+  for (int i = 0; i < HOST_PERF_EVENTS; ++i)
+  {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = events[i].type;
+    attr.config = events[i].config;
+    attr.disabled = leader < 0;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED |
+                       PERF_FORMAT_TOTAL_TIME_RUNNING;
+    fds[i] = perf_event_open(&attr, leader);
+    if (fds[i] < 0)
+    {
+      err = errno;
+      continue;
+    }
+    if (leader < 0)
+    {
+      leader = fds[i];
+    }
+    ++opened;
+  }
+  if (opened == 0)
+  {
+    errno = err;
+    return -1;
+  }
+  return opened;
+}
+
+void host_perf_close(void)
+{
+  for (int i = 0; i < HOST_PERF_EVENTS; ++i)
+  {
+    if (fds[i] >= 0)
+    {
+      close(fds[i]);
+      fds[i] = -1;
+    }
+  }
+  leader = -1;
+  opened = 0;
+}
+
+int host_perf_available(host_perf_event_t event)
+{
+  return opened > 0 && fds[event] >= 0;
+}
+
+const char *host_perf_name(host_perf_event_t event)
+{
+  return events[event].name;
+}
+
+/**
+ * @brief Resets and starts the counters.
+ */
+void host_perf_start(void)
+{
+  ioctl(leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+  ioctl(leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+}
+
+/**
+ * @brief Stops the counters and reads them.
+ *
+ * @param sample: the values, 0 for the unavailable counters
+ * @return int: 0 on success, -1 if the group could not be read or was not
+ *         scheduled on the CPU for the whole window (too many counters for
+ *         the PMU, or in use by another tool)
+ */
+int host_perf_stop(host_perf_sample_t *sample)
+{
+  ioctl(leader, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+  // Number of values, time enabled, time running, then the values
+  uint64_t buf[3 + HOST_PERF_EVENTS];
+  memset(sample, 0, sizeof(*sample));
+  ssize_t len = read(leader, buf, sizeof(buf));
+  if (len < (ssize_t)((3 + opened) * sizeof(uint64_t)) || buf[2] < buf[1])
+  {
+    return -1;
+  }
+  for (int i = 0, v = 0; i < HOST_PERF_EVENTS; ++i)
+  {
+    if (fds[i] >= 0)
+    {
+      sample->values[i] = buf[3 + v++];
+    }
+  }
+  return 0;
+}
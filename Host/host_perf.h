@@ -0,0 +1,45 @@
+/**
+ * @file host_perf.h
+ * @brief Hardware performance counters of the host harness, read around
+ * each kernel call with perf_event_open(2).
+ *
+ * The counters form a single group, so they are scheduled together and
+ * count over the same instructions; only user space is counted. A counter
+ * that the CPU or the kernel does not provide (virtual machines often have
+ * none) is left out and reported as unavailable, and the others are still
+ * read. With perf_event_paranoid > 2 the group cannot be opened at all.
+ */
+#ifndef HOST_PERF_H
+#define HOST_PERF_H
+
+#include <stdint.h>
+
+/**
+ * @brief Counters of the group, in the order of host_perf_sample_t.
+ */
+typedef enum
+{
+  HOST_PERF_CYCLES,
+  HOST_PERF_INSTRUCTIONS,
+  HOST_PERF_L1D_MISSES,    // L1 data cache read misses
+  HOST_PERF_LLC_MISSES,    // Last level cache misses
+  HOST_PERF_BRANCH_MISSES, // Mispredicted branches
+  HOST_PERF_EVENTS
+} host_perf_event_t;
+
+/**
+ * @brief Values of the counters over a window; 0 for the unavailable ones.
+ */
+typedef struct
+{
+  uint64_t values[HOST_PERF_EVENTS];
+} host_perf_sample_t;
+
+int host_perf_open(void);
+void host_perf_close(void);
+int host_perf_available(host_perf_event_t event);
+const char *host_perf_name(host_perf_event_t event);
+void host_perf_start(void);
+int host_perf_stop(host_perf_sample_t *sample);
+
+#endif
@@ -0,0 +1,187 @@
+/**
+ * @file bench_qemu.c
+ * @brief Emulated driver of the benchmark registry, for the QEMU mps2-an385
+ * machine (Cortex-M3).
+ *
+ * Runs every entry of the registry, with the inputs of the firmware (iteration
+ * i of a run is generated from bench_iteration_seed(BENCH_SEED, i)), and
+ * prints a summary line per run in the firmware's format, with the checksum
+ * of the outputs. QEMU then exits with a QEMU_EXIT_* status (see qemu_io.h),
+ * so the suite can run headless on a Linux machine without a board.
+ *
+ * The samples are instruction counts, measured with the timer of the machine
+ * under -icount (see qemu_io.h), minus the count of the empty timed window.
+ * The timer ticks are not whole instructions, so a sample is only within
+ * QEMU_INSN_ERROR instructions of the exact count; the summary line says so.
+ * They do not model the pipeline, the flash wait states or the memory of the
+ * STM32L152, but they are exact and reproducible for the code generated for
+ * the Cortex-M3: a regression in the instructions of a kernel shows as is.
+ *
+ * The kernel call of each timed window is delimited by calls of
+ * bench_marker_start() and bench_marker_stop(), for the counting plugin
+ * (see insn_plugin.c), which also counts the loads, stores and taken branches.
+ */
+
+#include <stdio.h>
+#include "bench.h"
+#include "bench_stats.h"
+#include "qemu_io.h"
+#include "simple_random.h"
+#include "visualizer.h"
+#include "pwm-fan-speed.h"
+#include "huffman-compression.h"
+#include "pathfind.h"
+
+// Measured iterations of each run
+#ifndef QEMU_ITERS
+#define QEMU_ITERS 20
+#endif
+
+// Registry entry to run, or -1 for all of them
+#ifndef QEMU_ENTRY
+#define QEMU_ENTRY -1
+#endif
+
+// When 1, every sample is printed before the summary line of its run
+#ifndef QEMU_RAW
+#define QEMU_RAW 0
+#endif
+
+// Number of runs of the empty kernel used to measure the timer overhead
+#define CALIBRATION_ITERS 16
+
+#define MAX(a, b) ((a) > (b) ? (a) : (b))
+
+// Largest input allowed by the kernels, in 8-byte words
+#define ARENA_WORDS                                                                         \
+  ((MAX(MAX(VIS_MAX_INPUT_SIZE * sizeof(double), PWM_MAX_INPUT_SIZE * sizeof(double)),     \
+        MAX(HUFFMAN_MAX_INPUT_SIZE * sizeof(unsigned int),                                  \
+            PATHFIND_MAX_INPUT_SIZE * sizeof(unsigned int))) + 7) / 8)
+
+static uint64_t arena[ARENA_WORDS];
+static uint32_t overhead;
+// Checksum returned by the last kernel call (see bench.c)
+static volatile unsigned int sink;
+
+// Markers of the kernel calls, found by their symbols (see insn_plugin.c)
+__attribute__((noinline)) void bench_marker_start(void)
+{
+  __asm volatile("");
+}
+
+__attribute__((noinline)) void bench_marker_stop(void)
+{
+  __asm volatile("");
+}
+
+/**
+ * @brief Measures a call of the kernel.
+ *
+ * @return uint32_t: the elapsed time, in timer ticks
+ */
+static uint32_t measure(const bench_t *bench, void *input)
+{
+  uint32_t start = qemu_timer_now();
+  bench_marker_start();
+  if (bench->input_type == BENCH_INPUT_DOUBLE)
+  {
+    sink = bench->run.f64((double *)input);
+  }
+  else
+  {
+    sink = bench->run.u32((unsigned int *)input);
+  }
+  bench_marker_stop();
+  return qemu_timer_now() - start;
+}
+
+__attribute__((noinline)) static unsigned int empty_u32(unsigned int *input)
+{
+  __asm volatile("" : : "r"(input) : "memory");
+  return 0;
+}
+
+/**
+ * @brief Measures the minimum time of the timed window around an empty
+ *        kernel, subtracted from every sample.
+ */
+static void calibrate(void)
+{
+  const bench_t empty = {.name = "Empty", .input_type = BENCH_INPUT_UINT, .run.u32 = empty_u32};
+  overhead = UINT32_MAX;
+  for (uint32_t i = 0; i < CALIBRATION_ITERS; ++i)
+  {
+    uint32_t t = measure(&empty, arena);
+    overhead = t < overhead ? t : overhead;
+  }
+  printf("Timer overhead: %lu insns, samples within +-%d insns\r\n",
+         (long unsigned int)qemu_ticks_to_insns(overhead), QEMU_INSN_ERROR);
+}
+
+/**
+ * @brief Runs a benchmark and prints its summary line.
+ *
+ * @return int: 0 on success, -1 if the configuration was rejected
+ */
+static int run(const bench_t *bench)
+{
+  if (bench->configure != NULL && bench->configure(bench) != 0)
+  {
+    printf("Invalid config %lu of %s\r\n", (long unsigned int)bench->config, bench->name);
+    return -1;
+  }
+  bench_stats_t stats;
+  bench_stats_init(&stats);
+  uint32_t checksum = BENCH_CHECKSUM_INIT;
+  for (uint32_t i = 0; i < QEMU_ITERS; ++i)
+  {
+    random_set_seed(bench_iteration_seed(BENCH_SEED, i));
+    bench->generate(bench, arena);
+    uint32_t t = measure(bench, arena);
+    checksum = bench_fold_checksum(checksum, sink);
+    uint64_t insns = qemu_ticks_to_insns(t > overhead ? t - overhead : 0);
+    bench_stats_add(&stats, insns);
+#if QEMU_RAW
+    printf("%lu\r\n", (long unsigned int)insns);
+#endif
+  }
+  printf("Stats %s config %lu: n=%lu min=%lu max=%lu mean=%lu stddev=%lu p50=%lu p90=%lu p99=%lu checksum=%08lx error=+-%d\r\n",
+         bench->name, (long unsigned int)bench->config, (long unsigned int)stats.count,
+         (long unsigned int)(stats.count ? stats.min : 0), (long unsigned int)stats.max,
+         (long unsigned int)(stats.mean + 0.5),
+         (long unsigned int)(bench_stats_stddev(&stats) + 0.5),
+         (long unsigned int)(bench_p2_get(&stats.p50) + 0.5),
+         (long unsigned int)(bench_p2_get(&stats.p90) + 0.5),
+         (long unsigned int)(bench_p2_get(&stats.p99) + 0.5), (long unsigned int)checksum,
+         QEMU_INSN_ERROR);
+  return 0;
+}
+
+int main(void)
+{
+  qemu_io_init();
+  if (QEMU_ENTRY >= (int)bench_registry_len)
+  {
+    printf("Invalid entry %d\r\n", QEMU_ENTRY);
+    return QEMU_EXIT_USAGE;
+  }
+  qemu_timer_start();
+  calibrate();
+  printf("Seed: %lu\r\n", (long unsigned int)BENCH_SEED);
+  int status = QEMU_EXIT_OK;
+  for (uint32_t i = 0; i < bench_registry_len; ++i)
+  {
+    if (QEMU_ENTRY >= 0 && i != (uint32_t)QEMU_ENTRY)
+    {
+      continue;
+    }
+    const bench_t *bench = &bench_registry[i];
+    printf("Start bench %s config %lu\r\n", bench->name, (long unsigned int)bench->config);
+    if (run(bench) != 0)
+    {
+      status = QEMU_EXIT_CONFIG;
+    }
+    printf("Done bench %s config %lu\r\n", bench->name, (long unsigned int)bench->config);
+  }
+  return status;
+}
@@ -0,0 +1,277 @@
+/**
+ * @file insn_plugin.c
+ * @brief QEMU TCG plugin counting the instructions, loads, stores and taken
+ * branches executed by each kernel call of the emulated build (see
+ * bench_qemu.c).
+ *
+ * A window opens when the guest executes bench_marker_start() and closes
+ * when it executes bench_marker_stop(); the markers are found by the symbols
+ * of the ELF file given to -kernel. At the end of each window a line
+ *   window <index> insns=<n> loads=<n> stores=<n> branches=<n>
+ * is written to the QEMU log (-d plugin, -D file), in the order of the
+ * windows of the guest: see Tools/qemu_counts.py to assign them to the runs.
+ *
+ * Loads and stores are memory accesses, so an LDM of four registers counts
+ * four loads. A translation block ends at the first branch, so a branch is
+ * counted as taken when the last instruction of a block is a branch (B, BL,
+ * BX, CBZ, TBB, a POP or LDM of the PC, a write of the PC, ...) and the next
+ * block does not start where that one ended. Exception entries do not count,
+ * and a taken branch to the following instruction counts as not taken. The
+ * branches are classified by the disassembly of QEMU. The counts of a window
+ * include the call sequence
+ * around the kernel in measure(), the same in every window: the calibration
+ * windows of the empty kernel measure it.
+ *
+ * The counts only depend on the guest code and its inputs, so they are the
+ * same in every run; QEMU does not need -icount.
+ *
+ * Arguments: start=<symbol>,stop=<symbol> to use other markers.
+ */
+
+#include <ctype.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <qemu-plugin.h>
+
+QEMU_PLUGIN_EXPORT int qemu_plugin_version = QEMU_PLUGIN_VERSION;
+
+typedef enum
+{
+  TB_CODE,  // Any code, counted inside a window
+  TB_START, // Code of the start marker
+  TB_STOP   // Code of the stop marker
+} tb_kind_t;
+
+/**
+ * @brief Translation block, as needed by the execution callbacks.
+ */
+typedef struct
+{
+  uint64_t vaddr; // Address of the first instruction
+  uint64_t end;   // Address following the last instruction
+  size_t n_insns;
+  bool branch; // The last instruction is a branch
+  tb_kind_t kind;
+} tb_info_t;
+
+/**
+ * @brief Counters of a window.
+ */
+typedef struct
+{
+  uint64_t insns;
+  uint64_t loads;
+  uint64_t stores;
+  uint64_t branches;
+} counts_t;
+
+static const char *start_symbol = "bench_marker_start";
+static const char *stop_symbol = "bench_marker_stop";
+
+// The machine has a single vCPU, so the state is global
+static bool active;
+static counts_t counts;
+static uint64_t last_end; // End of the last block executed in the window
+static bool last_branch;  // The last block executed in the window ends in a branch
+static uint64_t windows;
+
+static void window_open(const tb_info_t *tb)
+{
+  active = true;
+  memset(&counts, 0, sizeof(counts));
+  last_end = tb->end;
+  last_branch = tb->branch;
+}
+
+static void window_close(void)
+{
+  char line[160];
+  snprintf(line, sizeof(line),
+           "window %" PRIu64 " insns=%" PRIu64 " loads=%" PRIu64 " stores=%" PRIu64
+           " branches=%" PRIu64 "\n",
+           windows, counts.insns, counts.loads, counts.stores, counts.branches);
+  qemu_plugin_outs(line);
+  active = false;
+  ++windows;
+}
+
+static void tb_exec(unsigned int vcpu_index, void *userdata)
+{
+  (void)vcpu_index;
+  const tb_info_t *tb = userdata;
+  switch (tb->kind)
+  {
+  case TB_START:
+    window_open(tb);
+    break;
+  case TB_STOP:
+    if (active)
+    {
+      window_close();
+    }
+    break;
+  default:
+    if (active)
+    {
+      counts.insns += tb->n_insns;
+      if (last_branch && tb->vaddr != last_end)
+      {
+        ++counts.branches;
+      }
+      last_end = tb->end;
+      last_branch = tb->branch;
+    }
+    break;
+  }
+}
+
+static void mem_access(unsigned int vcpu_index, qemu_plugin_meminfo_t info, uint64_t vaddr,
+                       void *userdata)
+{
+  (void)vcpu_index;
+  (void)vaddr;
+  (void)userdata;
+  if (active)
+  {
+    if (qemu_plugin_mem_is_store(info))
+    {
+      ++counts.stores;
+    }
+    else
+    {
+      ++counts.loads;
+    }
+  }
+}
+
+/**
+ * @brief Tells whether an instruction may change the flow of the program,
+ *        from its disassembly ("<mnemonic> <operands>").
+ */
+static bool is_branch(const char *disas)
+{
+  static const char *const branches[] = {"b", "bl", "blx", "bx", "cbz", "cbnz", "tbb", "tbh"};
+  static const char *const conditions[] = {"eq", "ne", "cs", "hs", "cc", "lo", "mi", "pl", "vs",
+                                           "vc", "hi", "ls", "ge", "lt", "gt", "le", "al"};
+  char mnemonic[16];
+  size_t len = 0;
+  while (disas[len] != '\0' && !isspace((unsigned char)disas[len]) && len < sizeof(mnemonic) - 1)
+  {
+    mnemonic[len] = disas[len];
+    ++len;
+  }
+  mnemonic[len] = '\0';
+  const char *operands = disas + len;
+  while (isspace((unsigned char)*operands))
+  {
+    ++operands;
+  }
+  // Width qualifier of Thumb-2 (b.w, ldm.w)
+  char *dot = strchr(mnemonic, '.');
+  if (dot != NULL)
+  {
+    *dot = '\0';
+    len = dot - mnemonic;
+  }
+  for (size_t i = 0; i < sizeof(branches) / sizeof(branches[0]); ++i)
+  {
+    size_t base = strlen(branches[i]);
+    if (strncmp(mnemonic, branches[i], base) != 0)
+    {
+      continue;
+    }
+    if (len == base)
+    {
+      return true;
+    }
+    for (size_t j = 0; j < sizeof(conditions) / sizeof(conditions[0]); ++j)
+    {
+      if (len == base + 2 && strcmp(mnemonic + base, conditions[j]) == 0)
+      {
+        return true;
+      }
+    }
+  }
+  // Writes of the PC: mov pc, ldr pc, add pc, pop {..., pc}, ldm {..., pc}
+  if (strncmp(operands, "pc", 2) == 0 && (operands[2] == ',' || operands[2] == '\0'))
+  {
+    return true;
+  }
+  return (strncmp(mnemonic, "pop", 3) == 0 || strncmp(mnemonic, "ldm", 3) == 0) &&
+         strstr(operands, "pc}") != NULL;
+}
+
+static void tb_trans(qemu_plugin_id_t id, struct qemu_plugin_tb *tb)
+{
+  (void)id;
+  size_t n = qemu_plugin_tb_n_insns(tb);
+  tb_info_t *info = malloc(sizeof(*info));
+  if (info == NULL || n == 0)
+  {
+    free(info);
+    return;
+  }
+  struct qemu_plugin_insn *first = qemu_plugin_tb_get_insn(tb, 0);
+  struct qemu_plugin_insn *last = qemu_plugin_tb_get_insn(tb, n - 1);
+  info->vaddr = qemu_plugin_tb_vaddr(tb);
+  info->end = qemu_plugin_insn_vaddr(last) + qemu_plugin_insn_size(last);
+  info->n_insns = n;
+  char *disas = qemu_plugin_insn_disas(last);
+  info->branch = disas != NULL && is_branch(disas);
+  free(disas);
+  info->kind = TB_CODE;
+  const char *symbol = qemu_plugin_insn_symbol(first);
+  if (symbol != NULL && strcmp(symbol, start_symbol) == 0)
+  {
+    info->kind = TB_START;
+  }
+  else if (symbol != NULL && strcmp(symbol, stop_symbol) == 0)
+  {
+    info->kind = TB_STOP;
+  }
+  // The blocks are translated once and executed many times: the info is
+  // kept for the whole emulation
+  qemu_plugin_register_vcpu_tb_exec_cb(tb, tb_exec, QEMU_PLUGIN_CB_NO_REGS, info);
+  for (size_t i = 0; i < n; ++i)
+  {
+    qemu_plugin_register_vcpu_mem_cb(qemu_plugin_tb_get_insn(tb, i), mem_access,
+                                     QEMU_PLUGIN_CB_NO_REGS, QEMU_PLUGIN_MEM_RW, NULL);
+  }
+}
+
+static void plugin_exit(qemu_plugin_id_t id, void *userdata)
+{
+  (void)id;
+  (void)userdata;
+  char line[64];
+  snprintf(line, sizeof(line), "windows %" PRIu64 "\n", windows);
+  qemu_plugin_outs(line);
+}
+
+QEMU_PLUGIN_EXPORT int qemu_plugin_install(qemu_plugin_id_t id, const qemu_info_t *info,
+                                           int argc, char **argv)
+{
+  (void)info;
+  for (int i = 0; i < argc; ++i)
+  {
+    if (strncmp(argv[i], "start=", 6) == 0)
+    {
+      start_symbol = argv[i] + 6;
+    }
+    else if (strncmp(argv[i], "stop=", 5) == 0)
+    {
+      stop_symbol = argv[i] + 5;
+    }
+    else
+    {
+      fprintf(stderr, "insn_plugin: unknown argument %s\n", argv[i]);
+      return -1;
+    }
+  }
+  qemu_plugin_register_vcpu_tb_trans_cb(id, tb_trans);
+  qemu_plugin_register_atexit_cb(id, plugin_exit, NULL);
+  return 0;
+}
@@ -0,0 +1,174 @@
+/**
+ * @file qemu_io.c
+ * @brief Console, exit status and timer of the QEMU mps2-an385 machine, and
+ *        the system calls of newlib that use them. See qemu_io.h.
+ */
+
+#include <errno.h>
+#include <stddef.h>
+#include <sys/stat.h>
+#include "qemu_io.h"
+
+// Semihosting operations (Arm semihosting specification, version 2)
+#define SYS_OPEN 0x01
+#define SYS_WRITE 0x05
+#define SYS_EXIT_EXTENDED 0x20
+#define ADP_Stopped_ApplicationExit 0x20026
+
+// CMSDK APB UART0
+#define UART0_DATA (*(volatile uint32_t *)0x40004000)
+#define UART0_STATE (*(volatile uint32_t *)0x40004004)
+#define UART0_CTRL (*(volatile uint32_t *)0x40004008)
+#define UART0_BAUDDIV (*(volatile uint32_t *)0x40004010)
+#define UART_STATE_TX_FULL 0x1
+#define UART_CTRL_TX_EN 0x1
+
+// CMSDK APB timer 0, a 32-bit down counter
+#define TIMER0_CTRL (*(volatile uint32_t *)0x40000000)
+#define TIMER0_VALUE (*(volatile uint32_t *)0x40000004)
+#define TIMER0_RELOAD (*(volatile uint32_t *)0x40000008)
+#define TIMER_CTRL_EN 0x1
+
+// Frequency of the clock of the peripherals
+#define SYSCLK_HZ 25000000
+
+// Semihosting handle of the console, opened by qemu_io_init()
+static int console = -1;
+
+/**
+ * @brief Calls the semihosting operation op of the debugger, here QEMU.
+ *
+ * @param op: the operation
+ * @param arg: the parameter block of the operation
+ * @return int: the value returned in r0
+ */
+static int semihost(int op, void *arg)
+{
+  register int r0 __asm("r0") = op;
+  register void *r1 __asm("r1") = arg;
+  __asm volatile("bkpt 0xAB" : "+r"(r0) : "r"(r1) : "memory");
+  return r0;
+}
+
+/**
+ * @brief Opens the console, or enables the UART with QEMU_OUTPUT_UART.
+ */
+void qemu_io_init(void)
+{
+#if QEMU_OUTPUT_UART
+  // QEMU ignores the baud rate, but the divider must be at least 16
+  UART0_BAUDDIV = 16;
+  UART0_CTRL = UART_CTRL_TX_EN;
+#else
+  // ":tt" is the console; mode 4 is "w"
+  static const char tt[] = ":tt";
+  uint32_t args[3] = {(uint32_t)tt, 4, sizeof(tt) - 1};
+  console = semihost(SYS_OPEN, args);
+#endif
+}
+
+/**
+ * @brief Ends the emulation: QEMU exits with the given status.
+ *
+ * @param status: the exit status, one of QEMU_EXIT_*
+ */
+void qemu_exit(int status)
+{
+  uint32_t args[2] = {ADP_Stopped_ApplicationExit, status};
+  semihost(SYS_EXIT_EXTENDED, args);
+  // Not reached, unless semihosting is disabled
+  for (;;)
+  {
+  }
+}
+
+/**
+ * @brief Starts the timer, counting down from its maximum.
+ */
+void qemu_timer_start(void)
+{
+  TIMER0_CTRL = 0;
+  TIMER0_RELOAD = UINT32_MAX;
+  TIMER0_VALUE = UINT32_MAX;
+  TIMER0_CTRL = TIMER_CTRL_EN;
+}
+
+/**
+ * @brief Reads the timer as an up counter: the difference of two reads is the
+ *        number of ticks between them, modulo 2^32.
+ */
+uint32_t qemu_timer_now(void)
+{
+  return UINT32_MAX - TIMER0_VALUE;
+}
+
+/**
+ * @brief Converts ticks of the timer to instructions, 2^QEMU_ICOUNT_SHIFT ns
+ *        each, rounded to the nearest one (see QEMU_INSN_ERROR).
+ */
+uint64_t qemu_ticks_to_insns(uint64_t ticks)
+{
+  return (ticks * (2 * (1000000000 / SYSCLK_HZ)) + (1u << QEMU_ICOUNT_SHIFT)) >>
+         (QEMU_ICOUNT_SHIFT + 1);
+}
+
+int _write(int file, char *ptr, int len)
+{
+  (void)file;
+#if QEMU_OUTPUT_UART
+  for (int i = 0; i < len; ++i)
+  {
+    while (UART0_STATE & UART_STATE_TX_FULL)
+    {
+    }
+    UART0_DATA = (uint8_t)ptr[i];
+  }
+  return len;
+#else
+  uint32_t args[3] = {console, (uint32_t)ptr, len};
+  // SYS_WRITE returns the number of bytes not written
+  return len - semihost(SYS_WRITE, args);
+#endif
+}
+
+/**
+ * @brief The console is a character device, so that newlib line-buffers the
+ *        standard output (see syscalls.c of the firmware). The stubs of
+ *        libnosys fail, and the output would be fully buffered instead.
+ */
+int _fstat(int file, struct stat *st)
+{
+  (void)file;
+  st->st_mode = S_IFCHR;
+  return 0;
+}
+
+int _isatty(int file)
+{
+  (void)file;
+  return 1;
+}
+
+/**
+ * @brief Extends the heap of malloc, up to the stack reserve (_heap_limit in
+ *        mps2_an385.ld).
+ */
+void *_sbrk(ptrdiff_t incr)
+{
+  extern uint8_t end;
+  extern uint8_t _heap_limit;
+  static uint8_t *heap_end = &end;
+  if (heap_end + incr > &_heap_limit)
+  {
+    errno = ENOMEM;
+    return (void *)-1;
+  }
+  uint8_t *prev_heap_end = heap_end;
+  heap_end += incr;
+  return prev_heap_end;
+}
+
+void _exit(int status)
+{
+  qemu_exit(status);
+}
@@ -0,0 +1,54 @@
+/**
+ * @file qemu_io.h
+ * @brief Console, exit status and timer of the QEMU mps2-an385 machine.
+ *
+ * The standard output goes to the semihosting console, or to the emulated
+ * CMSDK UART0 with QEMU_OUTPUT_UART (QEMU's -serial, stdio with -nographic).
+ * The exit status is always reported with semihosting, so QEMU must run
+ * with -semihosting-config enable=on,target=native.
+ *
+ * The timer is the CMSDK APB timer 0, clocked at 25 MHz of virtual time.
+ * With -icount shift=QEMU_ICOUNT_SHIFT every instruction advances the virtual
+ * clock by 2^QEMU_ICOUNT_SHIFT ns, so the ticks are proportional to the
+ * executed instructions, and the same for every run of the same image.
+ *
+ * An instruction is not a whole number of ticks: a tick is 40 ns, and no
+ * power of 2 is a multiple of 40, so at the default shift of 6 a tick is
+ * 0.625 instructions. Each read of the timer drops the fraction of a tick, so
+ * a window minus the empty window is off by less than 2 ticks, 1.25
+ * instructions. The instruction count of a window is a whole number, so
+ * qemu_ticks_to_insns() rounds to the nearest one and the samples are within
+ * QEMU_INSN_ERROR instructions of the exact count. The counting plugin
+ * (insn_plugin.c) gives the exact counts.
+ */
+#ifndef QEMU_IO_H
+#define QEMU_IO_H
+
+#include <stdint.h>
+
+// When 1, the standard output goes to UART0 instead of semihosting
+#ifndef QEMU_OUTPUT_UART
+#define QEMU_OUTPUT_UART 0
+#endif
+
+// Value of -icount shift=N given to QEMU (see the qemu-run target)
+#ifndef QEMU_ICOUNT_SHIFT
+#define QEMU_ICOUNT_SHIFT 6
+#endif
+
+// Bound of the error of the samples, in instructions (see above)
+#define QEMU_INSN_ERROR 1
+
+// Exit status of the emulation
+#define QEMU_EXIT_OK 0
+#define QEMU_EXIT_CONFIG 1 // A registry entry was rejected by its kernel
+#define QEMU_EXIT_USAGE 2  // Invalid build options
+#define QEMU_EXIT_FAULT 3  // Unexpected exception (see startup_mps2_an385.s)
+
+void qemu_io_init(void);
+void qemu_exit(int status) __attribute__((noreturn));
+void qemu_timer_start(void);
+uint32_t qemu_timer_now(void);
+uint64_t qemu_ticks_to_insns(uint64_t ticks);
+
+#endif
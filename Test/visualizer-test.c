@@ -1,23 +1,16 @@
 /**
- * @file visualizer.c
+ * @file visualizer-test.c
  * @author Arturo Caliandro (arturo.caliandro AT mail.polimi.it)
- * @brief Time series visualizer.
- * The input is read and then drawn as a graph using the Bresenham algorithm.
+ * @brief Host test of the time series visualizer (Core/Src/visualizer.c).
+ * A fixed input is drawn and the image is written to output.pbm.
  */
 
-#include <math.h>
 #include <stdio.h>
+#include "visualizer.h"
 
-typedef struct {
-    int width;       // The width of the image
-    int height;      // The height of the image
-    int x_factor;    // The scaling factor for the x axis
-    double y_factor; // The scaling factor for the y axis
-    double min;      // The minimum value found so far
-} image_data;
-
-#define WIDTH 1920
-#define HEIGHT 1080
+// The image is bounded by VIS_MAX_WIDTH x VIS_MAX_HEIGHT
+#define WIDTH 300
+#define HEIGHT 200
 #define INPUT_SIZE 100
 double input[INPUT_SIZE] = {3.869142818076724666e+00, 2.841240192715680735e+00,
                             3.483596684378727382e+00, 3.374880936613904758e+00,
@@ -69,114 +62,31 @@ double input[INPUT_SIZE] = {3.869142818076724666e+00, 2.841240192715680735e+00,
                             9.011493658470167034e+00, 8.833482709777433328e+00,
                             9.938109436085706960e+00, 6.990229225213370867e+00,
                             2.243190590393101758e+00, 2.107190745065088855e+00};
-image_data im_data = {.width = WIDTH, .height = HEIGHT};
-
-void get_values(int n, double *min, double *max);
-void draw_line(char image[im_data.height][im_data.width], int x_0, double y_0,
-               double y_1);
 
-int main() {
-    char image[im_data.height][im_data.width];
-    for (int i = 0; i < im_data.height; ++i) {
-        for (int j = 0; j < im_data.width; ++j) {
-            image[i][j] = '0';
-        }
-    }
-    double y_max;
-    // Check if time series fits horizontally
-    int x_max = INPUT_SIZE;
-    if (INPUT_SIZE > im_data.width) {
-        // Input too big for the picture: truncating to the values compatible
-        // with the width of the image
-        x_max = im_data.width;
-        // Find the maximum and the minimum, again
-        // Scale maximum and minimum according to size of the image
-    }
-    get_values(x_max, &y_max, &im_data.min);
-    im_data.x_factor = im_data.width / x_max; // >= 1
-    if (im_data.min == y_max) {
-        // Constant value, to be plot in the half of the image as a line
-        im_data.min -= (im_data.height - 1) / 2.0;
-        im_data.y_factor = 1;
-    } else {
-        // To scale a y value, the used formula is:
-        // y_scaled = (height-1)*(y-min)/(max - min)
-        im_data.y_factor = (im_data.height - 1) / (y_max - im_data.min);
-    }
-    // For each couple of point of the input draw a line
-    for (int i = 1; i < x_max; ++i) {
-        draw_line(image, i, input[i - 1], input[i]);
-    }
-    // Write image on a file in PBM format
+/**
+ * @brief Writes the image on a file in PBM format.
+ */
+static void write_image(int height, int width, const char *image) {
     FILE *output = fopen("output.pbm", "w");
     fputs("P1\n", output);
-    fprintf(output, "%d %d\n", im_data.width, im_data.height);
-    for (int i = 0; i < im_data.height; ++i) {
-        for (int j = 0; j < im_data.width; ++j) {
-            fputc(image[i][j], output);
+    fprintf(output, "%d %d\n", width, height);
+    for (int i = 0; i < height; ++i) {
+        for (int j = 0; j < width; ++j) {
+            fputc(image[i * width + j], output);
         }
         fputc('\n', output);
     }
     fclose(output);
-    return 0;
-}
-
-/**
- * @brief Finds the min-max values inside the first n values of the input.
- *
- * @param n the number of values to consider
- * @param min the minimum found input value
- * @param max the maximum found input value
- */
-void get_values(int n, double *min, double *max) {
-    *min = INFINITY;
-    *max = -INFINITY;
-    for (int i = 0; i < n; ++i) {
-        if (input[i] < *min) {
-            *min = input[i];
-        }
-        if (input[i] > *max) {
-            *max = input[i];
-        }
-    }
 }
 
-/**
- * @brief Draw a line, using the Bresenham's Line Drawing algorithm.
- *
- * @param image the image representation
- * @param x_0 the final x value (used to find the start)
- * @param y_0 the first y value
- * @param y_1 the second y value
- */
-void draw_line(char image[im_data.height][im_data.width], int x_1, double y_0,
-               double y_1) {
-    x_1 *= im_data.x_factor;
-    int x = x_1 - im_data.x_factor;
-    int dx = im_data.x_factor;
-    int sign_x = 1;
-    int y = im_data.height - (im_data.y_factor * (y_0 - im_data.min)) - 1;
-    int y1 = im_data.height - (im_data.y_factor * (y_1 - im_data.min)) - 1;
-    int dy = -(y1 - y);
-    if (dy > 0) {
-        dy *= -1;
-    }
-    int sign_y = y < y1 ? 1 : -1;
-    int err = dx + dy;
-    int e2;
-    while (1) {
-        image[y][x] = '1';
-        if (x == x_1 && y == y1) {
-            break;
-        }
-        e2 = 2 * err;
-        if (e2 >= dy) {
-            err += dy;
-            x += sign_x;
-        }
-        if (e2 <= dx) {
-            err += dx;
-            y += sign_y;
-        }
+int main() {
+    const vis_config_t config = {
+        .width = WIDTH, .height = HEIGHT, .input_size = INPUT_SIZE};
+    if (visualizer_configure(&config) != 0) {
+        fprintf(stderr, "Invalid configuration\n");
+        return 1;
     }
+    visualizer_set_output(write_image);
+    visualizer(input);
+    return 0;
 }
@@ -0,0 +1,140 @@
+#!/usr/bin/env python3
+"""Decode the binary frames sent by the benchmark firmware.
+
+Reads a raw capture of the serial output (see Core/Inc/bench_output.h for the
+frame layout) and writes the samples of each benchmark and config to
+<outdir>/<name>_<config>.csv, one value per line, like the files in
+measurements/. In profiling mode each line also carries the DWT counters:
+cycles,cpi,exc,sleep,lsu,fold. Text between frames is echoed to stderr.
+
+In a clock sweep (BENCH_CLOCK_SWEEP) the runs are tagged with the clock
+logged before them ("Clock: <name>, ...") and written to
+<outdir>/<name>_<config>_<clock>.csv instead. In a flash accelerator sweep
+(BENCH_FLASH_SWEEP) the flash setting ("Flash: <setting>") is appended too,
+and in a comparison of the kernel placements (BENCH_RAM_KERNELS) the
+placement ("Placement: flash" or "Placement: RAM"), so that the runs of the
+two placements go to <name>_<config>_flash.csv and <name>_<config>_ram.csv.
+
+With --seeds, each line ends with the seed of the input of the iteration,
+derived from the base seed logged by the firmware ("Seed: N") as in
+bench_iteration_seed(): build the firmware with BENCH_REPLAY to time that
+iteration again.
+
+Usage: bench_frames.py [--seeds] capture.bin [outdir]
+"""
+import os
+import re
+import struct
+import sys
+import zlib
+
+MAGIC = b"\xb5\x62"
+FRAME_SAMPLES_U32 = 0x01
+FRAME_SAMPLES_U64 = 0x02
+FRAME_PROFILE = 0x03
+
+
+def iteration_seed(seed, index):
+    """Same as bench_iteration_seed() in Core/Src/bench_registry.c."""
+    h = (seed ^ (index * 0x9E3779B9)) & 0xFFFFFFFF
+    h ^= h >> 16
+    h = (h * 0x85EBCA6B) & 0xFFFFFFFF
+    h ^= h >> 13
+    h = (h * 0xC2B2AE35) & 0xFFFFFFFF
+    h ^= h >> 16
+    return h & 0x7FFFFFFF
+
+
+def parse(data):
+    """Yield (type, name, config, first, samples) for each valid frame, and
+    the text found between frames as str."""
+    pos = 0
+    text_start = 0
+    while True:
+        pos = data.find(MAGIC, pos)
+        if pos < 0 or pos + 4 > len(data):
+            break
+        (length,) = struct.unpack_from("<H", data, pos + 2)
+        body = data[pos + 4 : pos + 4 + length]
+        crc = data[pos + 4 + length : pos + 8 + length]
+        if len(crc) < 4 or zlib.crc32(body) != struct.unpack("<I", crc)[0]:
+            pos += 1
+            continue
+        if pos > text_start:
+            yield data[text_start:pos].decode("ascii", "replace")
+        ftype, config, name_len = body[0], body[1], body[2]
+        name = body[3 : 3 + name_len].decode("ascii", "replace")
+        first, count = struct.unpack_from("<IH", body, 3 + name_len)
+        if ftype == FRAME_SAMPLES_U32:
+            samples = struct.unpack_from("<%dI" % count, body, 9 + name_len)
+            yield (ftype, name, config, first, samples)
+        elif ftype == FRAME_SAMPLES_U64:
+            samples = struct.unpack_from("<%dQ" % count, body, 9 + name_len)
+            yield (ftype, name, config, first, samples)
+        elif ftype == FRAME_PROFILE:
+            raw = body[9 + name_len : 9 + name_len + 5 * count]
+            samples = [tuple(raw[i : i + 5]) for i in range(0, len(raw), 5)]
+            yield (ftype, name, config, first, samples)
+        pos += 8 + length
+        text_start = pos
+    if text_start < len(data):
+        yield data[text_start:].decode("ascii", "replace")
+
+
+def main():
+    args = sys.argv[1:]
+    seeds = "--seeds" in args
+    if seeds:
+        args.remove("--seeds")
+    if len(args) < 1:
+        sys.exit(__doc__)
+    outdir = args[1] if len(args) > 1 else "."
+    with open(args[0], "rb") as f:
+        data = f.read()
+    results = {}
+    base_seeds = {}
+    seed = None
+    clock = None
+    flash = None
+    placement = None
+    for item in parse(data):
+        if isinstance(item, str):
+            sys.stderr.write(item)
+            found = re.findall(r"Seed: (\d+)", item)
+            if found:
+                seed = int(found[-1])
+            found = re.findall(r"Clock: ([^,\r\n]+),", item)
+            if found:
+                clock = found[-1]
+            found = re.findall(r"Flash: ([^\r\n]+)", item)
+            if found:
+                flash = found[-1]
+            found = re.findall(r"Placement: (\S+)", item)
+            if found:
+                placement = found[-1]
+            continue
+        ftype, name, config, first, samples = item
+        tag = tuple(t for t in (clock, flash, placement) if t is not None)
+        base_seeds[(name, config, tag)] = seed
+        run = results.setdefault((name, config, tag), {})
+        for i, s in enumerate(samples):
+            if ftype == FRAME_PROFILE:
+                run.setdefault(first + i, [None])[1:] = s
+            else:
+                run.setdefault(first + i, [None])[0] = s
+    for (name, config, tag), run in results.items():
+        fname = "%s_%d" % (name.lower().replace(" ", "_"), config)
+        for t in tag:
+            fname += "_" + re.sub(r"[^0-9a-z]+", "_", t.lower()).strip("_")
+        fname += ".csv"
+        with open(os.path.join(outdir, fname), "w") as f:
+            for i in sorted(run):
+                row = run[i]
+                seed = base_seeds[(name, config, tag)]
+                if seeds and seed is not None:
+                    row = row + [iteration_seed(seed, i)]
+                f.write(",".join(str(v) for v in row) + "\n")
+
+
+if __name__ == "__main__":
+    main()
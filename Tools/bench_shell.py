@@ -0,0 +1,60 @@
+#!/usr/bin/env python3
+"""Drive the benchmark firmware built with BENCH_SHELL over a serial port.
+
+Sends each command (see Core/Inc/bench_shell.h), waits for its "OK" or
+"ERR" line, and appends everything the firmware sends to the capture file,
+which bench_frames.py decodes. The port can be a serial device or a pty
+(e.g. the serial port of QEMU). Stops at the first command that fails.
+
+Usage: bench_shell.py [--baud N] port capture.bin command...
+
+Example:
+  bench_shell.py /dev/ttyACM0 run.bin "select 3" "seed 7" "iters 500" run
+"""
+import re
+import sys
+
+import serial
+
+from bench_frames import parse
+
+# Last line of the output of a command
+END = re.compile(r"(^|\n)(OK|ERR [^\r\n]*)\r\n$")
+
+
+def send(port, capture, command):
+    """Send a command and return its last line, once it has arrived."""
+    port.write(command.encode("ascii") + b"\r\n")
+    data = b""
+    while True:
+        chunk = port.read(max(1, port.in_waiting))
+        if not chunk:
+            continue
+        capture.write(chunk)
+        data += chunk
+        # Only the text between frames can end the command
+        text = "".join(item for item in parse(data) if isinstance(item, str))
+        found = END.search(text)
+        if found:
+            return found.group(2)
+
+
+def main():
+    args = sys.argv[1:]
+    baud = 115200
+    if args[:1] == ["--baud"]:
+        baud = int(args[1])
+        args = args[2:]
+    if len(args) < 3:
+        sys.exit(__doc__)
+    with serial.serial_for_url(args[0], baud, timeout=1) as port, \
+            open(args[1], "ab") as capture:
+        for command in args[2:]:
+            result = send(port, capture, command)
+            sys.stderr.write("%s: %s\n" % (command, result))
+            if result != "OK":
+                sys.exit(1)
+
+
+if __name__ == "__main__":
+    main()
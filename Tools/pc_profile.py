@@ -0,0 +1,118 @@
+#!/usr/bin/env python3
+"""Symbolize the PC profiles sent by the benchmark firmware.
+
+Reads a raw capture of the serial output of a firmware built with
+BENCH_PC_PROFILE (see Core/Inc/bench_pcprof.h) and, for each profiled run,
+prints the samples per function and the hottest source lines, resolved
+against the ELF of the same build with nm and addr2line.
+
+The binutils of the cross toolchain are used by default; --prefix selects
+others (e.g. --prefix "" for the host ones).
+
+Usage: pc_profile.py [--prefix arm-none-eabi-] [--lines N] firmware.elf capture.bin
+"""
+import bisect
+import re
+import subprocess
+import sys
+
+from bench_frames import parse
+
+HEADER = re.compile(r"PC profile (.+) config (\d+): (\d+) samples, (\d+) dropped")
+ENTRY = re.compile(r"PC 0x([0-9a-fA-F]+) (\d+)")
+
+
+def read_profiles(data):
+    """Yield (name, config, total, dropped, {pc: count}) for each profile."""
+    text = "".join(item for item in parse(data) if isinstance(item, str))
+    profile = None
+    for line in text.splitlines():
+        found = HEADER.match(line)
+        if found:
+            name, config, total, dropped = found.groups()
+            profile = (name, int(config), int(total), int(dropped), {})
+            continue
+        if profile is None:
+            continue
+        found = ENTRY.match(line)
+        if found:
+            profile[4][int(found.group(1), 16)] = int(found.group(2))
+        elif line.startswith("PC profile end"):
+            yield profile
+            profile = None
+
+
+def read_symbols(prefix, elf):
+    """Return the sorted start addresses and the (end, name) of the functions."""
+    out = subprocess.run([prefix + "nm", "-C", "-S", "-n", "--defined-only", elf],
+                         capture_output=True, text=True, check=True).stdout
+    starts, funcs = [], []
+    for line in out.splitlines():
+        fields = line.split(None, 3)
+        if len(fields) < 4 or fields[2] not in "TtWw":
+            continue
+        # Thumb functions have the lowest bit set
+        start = int(fields[0], 16) & ~1
+        starts.append(start)
+        funcs.append((start + int(fields[1], 16), fields[3]))
+    return starts, funcs
+
+
+def function_of(pc, starts, funcs):
+    i = bisect.bisect_right(starts, pc) - 1
+    if i >= 0 and pc < funcs[i][0]:
+        return funcs[i][1]
+    return "0x%08x" % pc
+
+
+def source_lines(prefix, elf, pcs):
+    """Return {pc: "file:line"} for the given PCs."""
+    out = subprocess.run([prefix + "addr2line", "-e", elf],
+                         input="\n".join("0x%x" % pc for pc in pcs),
+                         capture_output=True, text=True, check=True).stdout
+    return dict(zip(pcs, out.splitlines()))
+
+
+def main():
+    args = sys.argv[1:]
+    prefix = "arm-none-eabi-"
+    n_lines = 20
+    while args and args[0].startswith("--"):
+        if args[0] == "--prefix" and len(args) > 1:
+            prefix = args[1]
+        elif args[0] == "--lines" and len(args) > 1:
+            n_lines = int(args[1])
+        else:
+            sys.exit(__doc__)
+        args = args[2:]
+    if len(args) != 2:
+        sys.exit(__doc__)
+    elf, capture = args
+    with open(capture, "rb") as f:
+        data = f.read()
+    starts, funcs = read_symbols(prefix, elf)
+    for name, config, total, dropped, counts in read_profiles(data):
+        recorded = sum(counts.values())
+        print("%s config %d: %d samples, %d dropped" % (name, config, total, dropped))
+        if recorded == 0:
+            continue
+        by_function = {}
+        for pc, count in counts.items():
+            func = function_of(pc, starts, funcs)
+            by_function[func] = by_function.get(func, 0) + count
+        print("  %8s %6s  %s" % ("samples", "%", "function"))
+        for func, count in sorted(by_function.items(), key=lambda kv: -kv[1]):
+            print("  %8d %6.2f  %s" % (count, 100.0 * count / recorded, func))
+        lines = source_lines(prefix, elf, sorted(counts))
+        by_line = {}
+        for pc, count in counts.items():
+            key = (lines.get(pc, "??:0"), function_of(pc, starts, funcs))
+            by_line[key] = by_line.get(key, 0) + count
+        print("  %8s %6s  %s" % ("samples", "%", "line"))
+        for (line, func), count in sorted(by_line.items(), key=lambda kv: -kv[1])[:n_lines]:
+            print("  %8d %6.2f  %s (%s)" % (count, 100.0 * count / recorded, line, func))
+        print()
+
+
+if __name__ == "__main__":
+    main()
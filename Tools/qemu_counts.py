@@ -0,0 +1,106 @@
+#!/usr/bin/env python3
+"""Assign the counts of the QEMU counting plugin to the benchmark runs.
+
+Reads the console output of the emulated build (Qemu/bench_qemu.c) and the
+log of the plugin (Qemu/insn_plugin.c), and writes the counts of each
+benchmark and config to <outdir>/<name>_<config>.csv, one iteration per line:
+insns,loads,stores,branches. The windows before the first run are the
+calibration windows of the empty kernel: their minimum is subtracted, so the
+counts are those of the kernel call alone.
+
+The counts are exact, so two builds can be compared iteration by iteration:
+with --baseline DIR, the total instructions of each run are compared with
+those of the CSV files in DIR (written by an earlier run of this script), and
+the script exits with status 1 if a run grew by more than --threshold
+(relative, 0.001 by default).
+
+Usage: qemu_counts.py [--baseline DIR] [--threshold T] console.log plugin.log
+                      [outdir]
+"""
+import argparse
+import os
+import re
+import sys
+
+COUNTERS = ("insns", "loads", "stores", "branches")
+
+
+def read_windows(path):
+    """Return the counters of each window, in order."""
+    windows = []
+    pattern = re.compile(
+        r"window (\d+) " + " ".join(r"%s=(\d+)" % c for c in COUNTERS)
+    )
+    with open(path) as f:
+        for line in f:
+            m = pattern.match(line)
+            if m:
+                windows.append(tuple(int(v) for v in m.groups()[1:]))
+    return windows
+
+
+def read_runs(path):
+    """Return (name, config, iterations) for each run, in order."""
+    runs = []
+    pattern = re.compile(r"Stats (.+) config (\d+): n=(\d+)")
+    with open(path, errors="replace") as f:
+        for line in f:
+            m = pattern.match(line.strip())
+            if m:
+                runs.append((m.group(1), int(m.group(2)), int(m.group(3))))
+    return runs
+
+
+def file_name(name, config):
+    return "%s_%d.csv" % (re.sub(r"[^A-Za-z0-9]", "_", name).lower(), config)
+
+
+def main():
+    parser = argparse.ArgumentParser(usage=__doc__)
+    parser.add_argument("--baseline")
+    parser.add_argument("--threshold", type=float, default=0.001)
+    parser.add_argument("console")
+    parser.add_argument("plugin_log")
+    parser.add_argument("outdir", nargs="?", default=".")
+    args = parser.parse_args()
+
+    windows = read_windows(args.plugin_log)
+    runs = read_runs(args.console)
+    calibration = len(windows) - sum(n for _, _, n in runs)
+    if calibration <= 0:
+        sys.exit("%d windows for %d iterations: no calibration windows"
+                 % (len(windows), len(windows) - calibration))
+    overhead = [min(w[i] for w in windows[:calibration])
+                for i in range(len(COUNTERS))]
+    print("Overhead: " + " ".join("%s=%d" % (c, v)
+                                  for c, v in zip(COUNTERS, overhead)))
+
+    regressions = 0
+    pos = calibration
+    for name, config, n in runs:
+        rows = [tuple(max(v - o, 0) for v, o in zip(w, overhead))
+                for w in windows[pos : pos + n]]
+        pos += n
+        fname = file_name(name, config)
+        with open(os.path.join(args.outdir, fname), "w") as f:
+            for row in rows:
+                f.write(",".join(str(v) for v in row) + "\n")
+        total = sum(r[0] for r in rows)
+        line = "%s config %d: %s" % (name, config, " ".join(
+            "%s=%d" % (c, sum(r[i] for r in rows))
+            for i, c in enumerate(COUNTERS)))
+        if args.baseline:
+            with open(os.path.join(args.baseline, fname)) as f:
+                base = sum(int(l.split(",")[0]) for l in f if l.strip())
+            delta = (total - base) / base if base else 0.0
+            line += " (%+.3f%%)" % (delta * 100)
+            if delta > args.threshold:
+                line += " REGRESSION"
+                regressions += 1
+        print(line)
+    if regressions:
+        sys.exit(1)
+
+
+if __name__ == "__main__":
+    main()